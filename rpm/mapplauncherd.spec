@@ -91,9 +91,14 @@ groupadd -rf privileged
 %defattr(-,root,root,-)
 %{_bindir}/invoker
 %{_bindir}/single-instance
+%{_bindir}/launch-events
 %{_libdir}/libapplauncherd.so*
+%dir %{_libdir}/mapplauncherd/boosters
+%dir %{_datadir}/mapplauncherd/preload
+%{_libdir}/mapplauncherd/boosters/booster-pie.so
 %attr(2755, root, privileged) %{_libexecdir}/mapplauncherd/booster-generic
 %{_libdir}/systemd/user/booster-generic.service
+%{_libdir}/systemd/user/booster-generic.socket
 %{_libdir}/systemd/user/user-session.target.wants/booster-generic.service
 # >> files
 # << files
@@ -21,6 +21,8 @@
 #include "launcherlib.h"
 #include "daemon.h"
 #include "logger.h"
+#include "eventlog.h"
+#include "probes.h"
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
@@ -49,6 +51,12 @@ int EBooster::launchProcess()
 
     dummyArgv[argc] = NULL;
 
+    EventLog::record(launch_event_main_entered, getpid(), 0, appData()->fileName().c_str());
+    LAUNCHER_PROBE1(main_entry, appData()->fileName().c_str());
+
+    // Pending log messages would be lost in exec
+    Logger::closeLog();
+
     // Exec the binary (execv returns only in case of an error).
     execv(appData()->fileName().c_str(), dummyArgv);
 
@@ -63,9 +71,11 @@ int EBooster::launchProcess()
 
 int main(int argc, char **argv)
 {
-    EBooster *booster = new EBooster;
-
     Daemon d(argc, argv);
-    d.run(booster);
+    d.addBooster(new EBooster);
+
+    // Boosters of other types are hosted by the same daemon
+    d.loadBoosterPlugins();
+    d.run();
 }
 
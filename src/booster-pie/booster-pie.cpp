@@ -0,0 +1,423 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "booster-pie.h"
+#include "elfimage.h"
+#include "launcherlib.h"
+#include "logger.h"
+#include "eventlog.h"
+#include "probes.h"
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+const string PBooster::m_boosterType = "pie";
+
+// Name of the fallback list in the socket directory
+static const char * const FALLBACK_LIST_NAME = "pie.fallback";
+
+// Name of the directory of loadable copies in the socket directory
+static const char * const COPY_DIR_NAME = "pie-copies";
+
+const string & PBooster::boosterType() const
+{
+    return m_boosterType;
+}
+
+// Return true if only this user can have written the file of st
+static bool isPrivate(const struct stat & st)
+{
+    return st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+// dl_iterate_phdr() callback returning the PT_INTERP of the main program,
+// which is always the first object reported
+static int findInterpreter(struct dl_phdr_info * info, size_t, void * data)
+{
+    for (int i = 0; i < info->dlpi_phnum; i++)
+    {
+        if (info->dlpi_phdr[i].p_type == PT_INTERP)
+        {
+            *static_cast<string *>(data) =
+                reinterpret_cast<const char *>(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+            break;
+        }
+    }
+
+    return 1;
+}
+
+bool PBooster::preload()
+{
+    dl_iterate_phdr(findInterpreter, &m_interpreter);
+
+    // The fallback list decides what is exec()'d and the copies are code
+    // that is loaded into applications, so both are kept only in the
+    // private runtime directory, which holds the booster sockets too
+    const char * runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (!runtimeDir || !*runtimeDir)
+    {
+        LOGGER_WARNING("PBooster: XDG_RUNTIME_DIR is not set, not remembering fallbacks");
+        return true;
+    }
+
+    const string dir = string(runtimeDir) + "/mapplauncherd";
+    struct stat st;
+    if (lstat(dir.c_str(), &st) == -1 || !S_ISDIR(st.st_mode) || !isPrivate(st))
+    {
+        LOGGER_WARNING("PBooster: %s is not private, not remembering fallbacks", dir.c_str());
+        return true;
+    }
+
+    m_fallbackPath = dir + "/" + FALLBACK_LIST_NAME;
+    readFallbackList();
+
+    m_copyDir = dir + "/" + COPY_DIR_NAME;
+    if ((mkdir(m_copyDir.c_str(), S_IRWXU) == -1 && errno != EEXIST) ||
+        lstat(m_copyDir.c_str(), &st) == -1 || !S_ISDIR(st.st_mode) || !isPrivate(st))
+    {
+        LOGGER_WARNING("PBooster: not caching loadable copies in %s", m_copyDir.c_str());
+        m_copyDir.clear();
+    }
+
+    return true;
+}
+
+string PBooster::fallbackKey(const struct stat & st)
+{
+    std::ostringstream key;
+    key << st.st_dev << ' ' << st.st_ino << ' ' << st.st_mtime;
+    return key.str();
+}
+
+void PBooster::readFallbackList()
+{
+    m_fallbacks.clear();
+
+    struct stat st;
+    if (lstat(m_fallbackPath.c_str(), &st) == -1)
+        return;
+
+    if (!S_ISREG(st.st_mode) || !isPrivate(st))
+    {
+        LOGGER_WARNING("PBooster: ignoring %s, it is not private", m_fallbackPath.c_str());
+        return;
+    }
+
+    // Each line is "<dev> <inode> <mtime> <path>", so a rebuilt
+    // executable gets a new chance to be loaded with dlopen()
+    std::ifstream list(m_fallbackPath.c_str());
+    string line;
+    while (std::getline(list, line))
+    {
+        std::istringstream fields(line);
+        string dev, ino, mtime;
+        if (fields >> dev >> ino >> mtime)
+            m_fallbacks.insert(dev + ' ' + ino + ' ' + mtime);
+    }
+}
+
+void PBooster::addToFallbackList(const struct stat & st, const string & reason)
+{
+    LOGGER_WARNING("PBooster: executing '%s' instead: %s",
+                   appData()->fileName().c_str(), reason.c_str());
+
+    if (m_fallbackPath.empty())
+        return;
+
+    const string line = fallbackKey(st) + ' ' + appData()->fileName() + '\n';
+
+    // Boosters of other types may append at the same time
+    int fd = open(m_fallbackPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | O_NOFOLLOW,
+                  S_IRUSR | S_IWUSR);
+    if (fd == -1 || write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size()))
+        LOGGER_ERROR("PBooster: can't update %s: %s", m_fallbackPath.c_str(), strerror(errno));
+
+    if (fd != -1)
+        close(fd);
+}
+
+string PBooster::incompatibility(const ElfImage & image) const
+{
+    if (!image.positionIndependent())
+        return "not a position independent executable";
+
+    if (!image.interpreter().empty() && image.interpreter() != m_interpreter)
+        return "requests dynamic linker " + image.interpreter();
+
+    // Local-exec TLS accesses in the executable assume that its TLS
+    // block is the first one, which is not the case after dlopen()
+    if (image.hasTls())
+        return "uses thread-local storage";
+
+    // DT_PREINIT_ARRAY is run only for the main program
+    if (image.hasPreinitArray())
+        return "has a preinit array";
+
+    return string();
+}
+
+// Write a copy of the executable to fd without the DF_1_PIE flag,
+// which makes dlopen() refuse to load it
+static bool writeLoadableCopy(int fd, const string & path, off_t flags1Offset, ElfW(Xword) flags1)
+{
+    int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in == -1)
+        return false;
+
+    struct stat st;
+    bool ok = fstat(in, &st) == 0;
+
+    off_t offset = 0;
+    while (ok && offset < st.st_size)
+        ok = sendfile(fd, in, &offset, st.st_size - offset) > 0;
+
+    close(in);
+
+    flags1 &= ~static_cast<ElfW(Xword)>(DF_1_PIE);
+    return ok && pwrite(fd, &flags1, sizeof(flags1), flags1Offset) == sizeof(flags1);
+}
+
+// Write the loadable copy into a memory file. Return the descriptor, -1 on failure.
+static int createLoadableCopy(const string & path, off_t flags1Offset, ElfW(Xword) flags1)
+{
+#ifdef SYS_memfd_create
+    int fd = syscall(SYS_memfd_create, "booster-pie", 0);
+    if (fd != -1 && !writeLoadableCopy(fd, path, flags1Offset, flags1))
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+#else
+    (void)path; (void)flags1Offset; (void)flags1;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int PBooster::openLoadableCopy(const ElfImage & image, const struct stat & st)
+{
+    const string & path = appData()->fileName();
+    if (m_copyDir.empty())
+        return createLoadableCopy(path, image.flags1Offset(), image.flags1());
+
+    // The copy gets the size and modification time of the executable,
+    // so a rebuilt executable doesn't match its old copy
+    std::ostringstream copyPath;
+    copyPath << m_copyDir << '/' << st.st_dev << '-' << st.st_ino;
+
+    int fd = open(copyPath.str().c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd != -1)
+    {
+        struct stat copySt;
+        if (fstat(fd, &copySt) == 0 && S_ISREG(copySt.st_mode) && isPrivate(copySt) &&
+            copySt.st_size == st.st_size && copySt.st_mtim.tv_sec == st.st_mtim.tv_sec &&
+            copySt.st_mtim.tv_nsec == st.st_mtim.tv_nsec)
+            return fd;
+
+        close(fd);
+    }
+
+    // Replace the copy atomically, applications loaded
+    // from the old one keep it until they exit
+    std::ostringstream tmpPath;
+    tmpPath << copyPath.str() << '.' << getpid();
+
+    fd = open(tmpPath.str().c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+        return createLoadableCopy(path, image.flags1Offset(), image.flags1());
+
+    const struct timespec times[2] = { { 0, UTIME_OMIT }, st.st_mtim };
+    if (!writeLoadableCopy(fd, path, image.flags1Offset(), image.flags1()) ||
+        futimens(fd, times) == -1 || rename(tmpPath.str().c_str(), copyPath.str().c_str()) == -1)
+    {
+        LOGGER_WARNING("PBooster: can't cache a loadable copy of '%s': %s", path.c_str(), strerror(errno));
+        unlink(tmpPath.str().c_str());
+        close(fd);
+        return createLoadableCopy(path, image.flags1Offset(), image.flags1());
+    }
+
+    LOGGER_DEBUG("PBooster: cached a loadable copy of '%s'", path.c_str());
+    return fd;
+}
+
+entry_t PBooster::loadPie(const ElfImage & image, const struct stat & st, string & reason)
+{
+    int dlopenFlags = RTLD_LAZY;
+
+    if (appData()->dlopenGlobal())
+        dlopenFlags |= RTLD_GLOBAL;
+    else
+        dlopenFlags |= RTLD_LOCAL;
+
+    if (appData()->dlopenDeep())
+        dlopenFlags |= RTLD_DEEPBIND;
+
+    string path = appData()->fileName();
+    int copyFd = -1;
+    if (image.flags1() & DF_1_PIE)
+    {
+        copyFd = openLoadableCopy(image, st);
+        if (copyFd == -1)
+        {
+            reason = string("can't copy the executable: ") + strerror(errno);
+            return NULL;
+        }
+
+        std::ostringstream fdPath;
+        fdPath << "/proc/self/fd/" << copyFd;
+        path = fdPath.str();
+    }
+
+    LAUNCHER_PROBE1(dlopen_begin, appData()->fileName().c_str());
+    void * module = dlopen(path.c_str(), dlopenFlags);
+    LAUNCHER_PROBE1(dlopen_end, appData()->fileName().c_str());
+
+    // The mapping keeps the copy alive
+    if (copyFd != -1)
+        close(copyFd);
+
+    if (!module)
+    {
+        reason = dlerror();
+        return NULL;
+    }
+
+    dlerror();
+    void * entry = dlsym(module, "main");
+
+    // main() is not exported unless the executable is linked with
+    // -rdynamic, so fall back to the static symbol table
+    if (!entry)
+    {
+        struct link_map * map = NULL;
+        const ElfW(Addr) value = image.findSymbol("main");
+        if (value && dlinfo(module, RTLD_DI_LINKMAP, &map) == 0 && map)
+            entry = reinterpret_cast<void *>(map->l_addr + value);
+    }
+
+    if (!entry)
+    {
+        // Constructors of the executable have already run, so
+        // it can't be unloaded safely before exec()
+        reason = "symbol 'main' not found";
+        return NULL;
+    }
+
+    return reinterpret_cast<entry_t>(entry);
+}
+
+int PBooster::execApplication()
+{
+    // Ensure a NULL-terminated argv
+    const int argc = appData()->argc();
+    char ** dummyArgv = new char * [argc + 1];
+    for (int i = 0; i < argc; i++)
+        dummyArgv[i] = strdup(appData()->argv()[i]);
+
+    dummyArgv[argc] = NULL;
+
+    EventLog::record(launch_event_main_entered, getpid(), 0, appData()->fileName().c_str());
+    LAUNCHER_PROBE1(main_entry, appData()->fileName().c_str());
+
+    // Pending log messages would be lost in exec
+    Logger::closeLog();
+
+    // Exec the binary (execv returns only in case of an error).
+    execv(appData()->fileName().c_str(), dummyArgv);
+
+    // Delete dummy argv if execv failed
+    for (int i = 0; i < argc; i++)
+        free(dummyArgv[i]);
+
+    delete [] dummyArgv;
+
+    return EXIT_FAILURE;
+}
+
+int PBooster::launchProcess()
+{
+    setEnvironmentBeforeLaunch();
+
+    struct stat st;
+    if (stat(appData()->fileName().c_str(), &st) == -1 ||
+        m_fallbacks.count(fallbackKey(st)))
+        return execApplication();
+
+    ElfImage image;
+    string reason;
+    if (!image.read(appData()->fileName(), reason))
+    {
+        // Scripts and the like: exec() them without remembering
+        LOGGER_DEBUG("PBooster: '%s': %s", appData()->fileName().c_str(), reason.c_str());
+        return execApplication();
+    }
+
+    reason = incompatibility(image);
+
+    entry_t entry = NULL;
+    if (reason.empty())
+        entry = loadPie(image, st, reason);
+
+    if (!entry)
+    {
+        addToFallbackList(st, reason);
+        return execApplication();
+    }
+
+    appData()->setEntry(entry);
+
+    // The C library took these from the argv of the booster
+    program_invocation_name = strdup(appData()->argv()[0]);
+    const char * slash = strrchr(program_invocation_name, '/');
+    program_invocation_short_name = slash ? const_cast<char *>(slash + 1) : program_invocation_name;
+
+    // make booster specific initializations unless booster is in boot mode
+    if (!bootMode())
+        preinit();
+
+    EventLog::record(launch_event_main_entered, getpid(), 0, appData()->fileName().c_str());
+    LAUNCHER_PROBE1(main_entry, appData()->fileName().c_str());
+
+    // Write out pending messages and close the log so that
+    // the application doesn't inherit any log descriptors
+    Logger::closeLog();
+    EventLog::close();
+
+    // Jump to main() and return from it the way __libc_start_main() does:
+    // exit() runs the atexit() handlers and the destructors of the
+    // executable and flushes stdio, which _exit() in the daemon would skip
+    exit(appData()->entry()(appData()->argc(), const_cast<char **>(appData()->argv())));
+}
+
+BOOSTER_PLUGIN(PBooster)
@@ -0,0 +1,120 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef BOOSTER_PIE_H
+#define BOOSTER_PIE_H
+
+#include "booster.h"
+
+#include <sys/stat.h>
+
+#include <string>
+
+using std::string;
+
+#include <set>
+
+using std::set;
+
+class ElfImage;
+
+/*!
+    \class PBooster
+    \brief PBooster launches unmodified PIE executables without exec().
+
+    The executable is loaded into the booster with dlopen() like
+    Booster::launchProcess() does and its main() is called, so the
+    libraries preloaded by the booster stay in use. Executables that
+    can't be loaded this way are exec()'d instead, and remembered in
+    a fallback list so that later launches exec() them right away.
+
+    Executables marked as PIE are loaded from a patched copy, which is
+    cached in the runtime directory until the executable changes.
+
+    dlopen() runs the constructors of the executable, and exit() is called
+    with the return value of main(), so the exit handlers, destructors and
+    stdio buffers are handled as after a normal start. The .preinit_array
+    of the executable is not run and the auxiliary vector stays that of the
+    booster.
+
+    PBooster is a plugin of booster-generic and has the type "pie".
+ */
+class PBooster : public Booster
+{
+public:
+
+    PBooster() {}
+    virtual ~PBooster() {}
+
+    //! \reimp
+    virtual const string & boosterType() const;
+
+protected:
+
+    //! \reimp
+    virtual int launchProcess();
+
+    //! \reimp
+    virtual bool preload();
+
+private:
+
+    //! Disable copy-constructor
+    PBooster(const PBooster & r);
+
+    //! Disable assignment operator
+    PBooster & operator= (const PBooster & r);
+
+    //! Return the reason why image can't be loaded with dlopen(), empty if it can
+    string incompatibility(const ElfImage & image) const;
+
+    //! Load the application with dlopen() and return the address of main(), NULL on failure
+    entry_t loadPie(const ElfImage & image, const struct stat & st, string & reason);
+
+    //! Return a descriptor of a copy of the executable that dlopen() accepts, -1 on failure
+    int openLoadableCopy(const ElfImage & image, const struct stat & st);
+
+    //! Return the key of the executable in the fallback list
+    static string fallbackKey(const struct stat & st);
+
+    //! Read the fallback list
+    void readFallbackList();
+
+    //! Add the application to the fallback list
+    void addToFallbackList(const struct stat & st, const string & reason);
+
+    //! Exec the application, returns only on error
+    int execApplication();
+
+    static const string m_boosterType;
+
+    //! Path of the fallback list, empty if it isn't kept
+    string m_fallbackPath;
+
+    //! Keys of the executables to be exec()'d
+    set<string> m_fallbacks;
+
+    //! Directory of the cached loadable copies, empty if they aren't cached
+    string m_copyDir;
+
+    //! Dynamic linker of the booster
+    string m_interpreter;
+};
+
+#endif // BOOSTER_PIE_H
@@ -0,0 +1,215 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "elfimage.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+using std::vector;
+
+// Read exactly size bytes at offset
+static bool readAt(int fd, void * buf, size_t size, off_t offset)
+{
+    return pread(fd, buf, size, offset) == static_cast<ssize_t>(size);
+}
+
+ElfImage::ElfImage() :
+    m_type(ET_NONE),
+    m_tls(false),
+    m_preinitArray(false),
+    m_flags1(0),
+    m_flags1Offset(-1)
+{}
+
+bool ElfImage::read(const string & path, string & reason)
+{
+    m_path = path;
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        reason = string("can't open: ") + strerror(errno);
+        return false;
+    }
+
+    ElfW(Ehdr) ehdr;
+    if (!readAt(fd, &ehdr, sizeof(ehdr), 0) || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr.e_ident[EI_CLASS] != __ELF_NATIVE_CLASS / 32 ||
+        ehdr.e_phentsize != sizeof(ElfW(Phdr)))
+    {
+        reason = "not an ELF object of this architecture";
+        close(fd);
+        return false;
+    }
+
+    m_type = ehdr.e_type;
+
+    vector<ElfW(Phdr)> phdrs(ehdr.e_phnum);
+    if (ehdr.e_phnum && !readAt(fd, &phdrs[0], ehdr.e_phnum * sizeof(ElfW(Phdr)), ehdr.e_phoff))
+    {
+        reason = "truncated program headers";
+        close(fd);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < phdrs.size(); i++)
+    {
+        switch (phdrs[i].p_type)
+        {
+        case PT_INTERP:
+        {
+            vector<char> interp(phdrs[i].p_filesz + 1, '\0');
+            if (phdrs[i].p_filesz < PATH_MAX &&
+                readAt(fd, &interp[0], phdrs[i].p_filesz, phdrs[i].p_offset))
+                m_interpreter = &interp[0];
+            break;
+        }
+
+        case PT_TLS:
+            m_tls = true;
+            break;
+
+        case PT_DYNAMIC:
+            if (!readDynamic(fd, phdrs[i]))
+            {
+                reason = "truncated dynamic section";
+                close(fd);
+                return false;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    close(fd);
+    return true;
+}
+
+bool ElfImage::readDynamic(int fd, const ElfW(Phdr) & phdr)
+{
+    const size_t count = phdr.p_filesz / sizeof(ElfW(Dyn));
+    if (!count)
+        return true;
+
+    vector<ElfW(Dyn)> dyn(count);
+    if (!readAt(fd, &dyn[0], count * sizeof(ElfW(Dyn)), phdr.p_offset))
+        return false;
+
+    for (size_t i = 0; i < count && dyn[i].d_tag != DT_NULL; i++)
+    {
+        if (dyn[i].d_tag == DT_FLAGS_1)
+        {
+            m_flags1 = dyn[i].d_un.d_val;
+            m_flags1Offset = phdr.p_offset + i * sizeof(ElfW(Dyn)) + offsetof(ElfW(Dyn), d_un);
+        }
+        else if (dyn[i].d_tag == DT_PREINIT_ARRAYSZ && dyn[i].d_un.d_val)
+        {
+            m_preinitArray = true;
+        }
+    }
+
+    return true;
+}
+
+bool ElfImage::positionIndependent() const
+{
+    return m_type == ET_DYN;
+}
+
+const string & ElfImage::interpreter() const
+{
+    return m_interpreter;
+}
+
+bool ElfImage::hasTls() const
+{
+    return m_tls;
+}
+
+bool ElfImage::hasPreinitArray() const
+{
+    return m_preinitArray;
+}
+
+ElfW(Xword) ElfImage::flags1() const
+{
+    return m_flags1;
+}
+
+off_t ElfImage::flags1Offset() const
+{
+    return m_flags1Offset;
+}
+
+ElfW(Addr) ElfImage::findSymbol(const char * name) const
+{
+    int fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return 0;
+
+    ElfW(Ehdr) ehdr;
+    vector<ElfW(Shdr)> shdrs;
+    if (readAt(fd, &ehdr, sizeof(ehdr), 0) && ehdr.e_shentsize == sizeof(ElfW(Shdr)) && ehdr.e_shnum)
+    {
+        shdrs.resize(ehdr.e_shnum);
+        if (!readAt(fd, &shdrs[0], ehdr.e_shnum * sizeof(ElfW(Shdr)), ehdr.e_shoff))
+            shdrs.clear();
+    }
+
+    ElfW(Addr) value = 0;
+    for (unsigned int i = 0; i < shdrs.size() && !value; i++)
+    {
+        const ElfW(Shdr) & symtab = shdrs[i];
+        if (symtab.sh_type != SHT_SYMTAB || symtab.sh_link >= shdrs.size())
+            continue;
+
+        const ElfW(Shdr) & strtab = shdrs[symtab.sh_link];
+        const size_t count = symtab.sh_size / sizeof(ElfW(Sym));
+        if (!count || !strtab.sh_size)
+            continue;
+
+        vector<ElfW(Sym)> syms(count);
+        vector<char> strs(strtab.sh_size + 1, '\0');
+        if (!readAt(fd, &syms[0], count * sizeof(ElfW(Sym)), symtab.sh_offset) ||
+            !readAt(fd, &strs[0], strtab.sh_size, strtab.sh_offset))
+            continue;
+
+        for (size_t j = 0; j < count; j++)
+        {
+            if (ELF64_ST_TYPE(syms[j].st_info) == STT_FUNC && syms[j].st_shndx != SHN_UNDEF &&
+                syms[j].st_name < strtab.sh_size && strcmp(&strs[syms[j].st_name], name) == 0)
+            {
+                value = syms[j].st_value;
+                break;
+            }
+        }
+    }
+
+    close(fd);
+    return value;
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef ELFIMAGE_H
+#define ELFIMAGE_H
+
+#include <link.h>
+#include <sys/types.h>
+
+#include <string>
+
+using std::string;
+
+/*!
+ * \class ElfImage
+ * \brief Reads the headers of an ELF file that matter for loading it with dlopen().
+ *
+ * Only the ELF header, the program headers and the dynamic section are
+ * read. The symbol table is read only when a symbol is looked up.
+ */
+class ElfImage
+{
+public:
+
+    ElfImage();
+
+    /*! \brief Read the headers of the file at path.
+     *  \param reason Receives the reason if the file can't be read.
+     *  \return false if the file is not an ELF object of this ELF class.
+     */
+    bool read(const string & path, string & reason);
+
+    //! Return true for position independent executables and shared objects (ET_DYN)
+    bool positionIndependent() const;
+
+    //! Return the dynamic linker requested with PT_INTERP, empty if none
+    const string & interpreter() const;
+
+    //! Return true if the object has a thread-local storage segment (PT_TLS)
+    bool hasTls() const;
+
+    //! Return true if the object has a non-empty DT_PREINIT_ARRAY
+    bool hasPreinitArray() const;
+
+    //! Return the DT_FLAGS_1 value of the object
+    ElfW(Xword) flags1() const;
+
+    //! Return the file offset of the DT_FLAGS_1 value, -1 if the object has none
+    off_t flags1Offset() const;
+
+    /*! \brief Look up a symbol in the static symbol table (.symtab).
+     *  \return the value of the symbol, 0 if not found or the file is stripped.
+     */
+    ElfW(Addr) findSymbol(const char * name) const;
+
+private:
+
+    //! Read the dynamic section described by phdr
+    bool readDynamic(int fd, const ElfW(Phdr) & phdr);
+
+    //! Path of the file
+    string m_path;
+
+    //! Object type (e_type)
+    ElfW(Half) m_type;
+
+    //! Requested dynamic linker
+    string m_interpreter;
+
+    //! True if there is a PT_TLS segment
+    bool m_tls;
+
+    //! True if there is a non-empty DT_PREINIT_ARRAY
+    bool m_preinitArray;
+
+    //! Value and file offset of DT_FLAGS_1
+    ElfW(Xword) m_flags1;
+    off_t m_flags1Offset;
+};
+
+#endif // ELFIMAGE_H
@@ -0,0 +1,87 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef LAUNCHEVENTS_H
+#define LAUNCHEVENTS_H
+
+#include <stdint.h>
+
+/* Binary launch event journal.
+ *
+ * The daemon and its boosters append fixed-size records to a ring file
+ * next to the booster socket, <socket>.events. The file is mapped shared
+ * by all of them, so a record costs a reservation with an atomic
+ * increment of the header's next counter and a few stores. A record is
+ * complete when its sequence equals its index + 1; the sequence is
+ * written last. The launch-events tool decodes the file. */
+
+#define LAUNCH_EVENTS_SUFFIX   ".events"
+#define LAUNCH_EVENTS_MAGIC    0xe7e10001
+#define LAUNCH_EVENTS_CAPACITY 4096
+#define LAUNCH_EVENTS_APP_LEN  32
+
+enum launch_event_type {
+  /* daemon accepted an invoker connection, value: connection id */
+  launch_event_received = 1,
+  /* daemon handed a connection to booster pid, value: connection id */
+  launch_event_booster_chosen,
+  /* daemon forked booster pid, value: respawn delay in seconds */
+  launch_event_fork,
+  /* booster pid jumps to main() of app */
+  launch_event_main_entered,
+  /* daemon reaped launched application pid, value: wait status */
+  launch_event_exit,
+  /* daemon starts replacing the booster, value: respawn delay in seconds */
+  launch_event_respawn_started,
+  /* booster pid is ready for the next launch */
+  launch_event_respawn_finished,
+  /* daemon stopped idle booster pid, value: idle time in seconds */
+  launch_event_booster_stopped,
+  /* daemon queued a connection for a booster, value: queue length, app: booster type */
+  launch_event_queued,
+  /* booster pid trimmed its memory after preloading, value: RSS in kB, app: booster type */
+  launch_event_booster_rss,
+  /* booster pid trimmed its memory after preloading, value: PSS in kB, app: booster type */
+  launch_event_booster_pss,
+  /* daemon stopped idle booster pid for memory pressure, value: some avg10 in 1/100 %, app: booster type */
+  launch_event_booster_evicted,
+  /* daemon forks boosters again after memory pressure, value: some avg10 in 1/100 %, app: booster type */
+  launch_event_booster_rewarmed
+};
+
+/* One event, 64 bytes */
+struct launch_event {
+  uint64_t sequence;   /* index of the record + 1, 0 if never written */
+  uint64_t timestamp;  /* CLOCK_MONOTONIC in nanoseconds */
+  int32_t  pid;
+  uint32_t type;       /* enum launch_event_type */
+  int32_t  value;
+  uint32_t reserved;
+  char     app[LAUNCH_EVENTS_APP_LEN]; /* basename, may lack the terminating null */
+};
+
+/* Header of the ring file, followed by capacity records */
+struct launch_events_header {
+  uint32_t magic;
+  uint32_t capacity;
+  uint64_t next;       /* number of records ever reserved */
+  uint8_t  reserved[48];
+};
+
+#endif
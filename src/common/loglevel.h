@@ -0,0 +1,76 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef LOGLEVEL_H
+#define LOGLEVEL_H
+
+/* Log levels shared by invoker and the launcher library. Messages above
+ * LOGLEVEL_MAX are compiled out together with their arguments. */
+#define LOGLEVEL_ERROR   0
+#define LOGLEVEL_WARNING 1
+#define LOGLEVEL_INFO    2
+#define LOGLEVEL_DEBUG   3
+#define LOGLEVEL_TRACE   4
+
+#ifndef LOGLEVEL_MAX
+#define LOGLEVEL_MAX LOGLEVEL_DEBUG
+#endif
+
+/* LOGLEVEL_<LEVEL>_CALL(enabled, call) evaluates call, and so the
+ * arguments of the message, only if the level is compiled in and the
+ * runtime condition enabled holds. A level that is compiled out still
+ * sees call in dead code, so its arguments are type checked and count
+ * as used, and the compiler drops it. */
+#define LOGLEVEL_CALL_IF(enabled, call) \
+    do { if (enabled) { call; } } while (0)
+
+#define LOGLEVEL_CALL_NONE(enabled, call) \
+    do { if (0) { call; } } while (0)
+
+#if LOGLEVEL_MAX >= LOGLEVEL_ERROR
+#define LOGLEVEL_ERROR_CALL LOGLEVEL_CALL_IF
+#else
+#define LOGLEVEL_ERROR_CALL LOGLEVEL_CALL_NONE
+#endif
+
+#if LOGLEVEL_MAX >= LOGLEVEL_WARNING
+#define LOGLEVEL_WARNING_CALL LOGLEVEL_CALL_IF
+#else
+#define LOGLEVEL_WARNING_CALL LOGLEVEL_CALL_NONE
+#endif
+
+#if LOGLEVEL_MAX >= LOGLEVEL_INFO
+#define LOGLEVEL_INFO_CALL LOGLEVEL_CALL_IF
+#else
+#define LOGLEVEL_INFO_CALL LOGLEVEL_CALL_NONE
+#endif
+
+#if LOGLEVEL_MAX >= LOGLEVEL_DEBUG
+#define LOGLEVEL_DEBUG_CALL LOGLEVEL_CALL_IF
+#else
+#define LOGLEVEL_DEBUG_CALL LOGLEVEL_CALL_NONE
+#endif
+
+#if LOGLEVEL_MAX >= LOGLEVEL_TRACE
+#define LOGLEVEL_TRACE_CALL LOGLEVEL_CALL_IF
+#else
+#define LOGLEVEL_TRACE_CALL LOGLEVEL_CALL_NONE
+#endif
+
+#endif
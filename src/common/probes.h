@@ -0,0 +1,36 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef PROBES_H
+#define PROBES_H
+
+/* Static user-space tracepoints (USDT) of invoker, the launcher daemon and
+ * boosters, all in provider "applauncherd". A probe compiles to a single nop
+ * and a note describing its arguments, which tracers such as perf and
+ * bpftrace patch only when they attach. The notes are generated by the
+ * bundled sdt.h, so no SystemTap headers are needed to build. See
+ * scripts/launch-latency.bt for an example. */
+
+#include "sdt.h"
+
+#define LAUNCHER_PROBE(name) SDT_PROBE0(applauncherd, name)
+#define LAUNCHER_PROBE1(name, a1) SDT_PROBE1(applauncherd, name, a1)
+#define LAUNCHER_PROBE2(name, a1, a2) SDT_PROBE2(applauncherd, name, a1, a2)
+
+#endif
@@ -30,9 +30,12 @@ const uint32_t INVOKER_MSG_MAGIC_OPTION_WAIT              = 0x00000001;
 const uint32_t INVOKER_MSG_MAGIC_OPTION_DLOPEN_GLOBAL     = 0x00000002;
 const uint32_t INVOKER_MSG_MAGIC_OPTION_DLOPEN_DEEP       = 0x00000004;
 const uint32_t INVOKER_MSG_MAGIC_OPTION_SINGLE_INSTANCE   = 0x00000008;
-/* 0x00000010 was INVOKER_MSG_MAGIC_OPTION_SPLASH_SCREEN */
+/* 0x00000010 was INVOKER_MSG_MAGIC_OPTION_SPLASH_SCREEN, now: */
+const uint32_t INVOKER_MSG_MAGIC_OPTION_BACKGROUND        = 0x00000010;
 const uint32_t INVOKER_MSG_MAGIC_OPTION_OOM_ADJ_DISABLE   = 0x00000020;
-/* 0x00000040 was INVOKER_MSG_MAGIC_OPTION_LANDSCAPE_SPLASH_SCREEN */
+/* 0x00000040 was INVOKER_MSG_MAGIC_OPTION_LANDSCAPE_SPLASH_SCREEN, now: */
+const uint32_t INVOKER_MSG_MAGIC_OPTION_BATCH             = 0x00000040;
+const uint32_t INVOKER_MSG_MAGIC_OPTION_NO_ACK            = 0x00000080;
 
 
 const uint32_t INVOKER_MSG_MASK               = 0xffff0000;
@@ -45,12 +48,57 @@ const uint32_t INVOKER_MSG_PRIO               = 0xa1ce0000;
 const uint32_t INVOKER_MSG_DELAY              = 0xb2de0012;
 const uint32_t INVOKER_MSG_IDS                = 0xb2df4000;
 const uint32_t INVOKER_MSG_IO                 = 0x10fd0000;
+/* Followed by uclamp.min in percent and its duration in milliseconds */
+const uint32_t INVOKER_MSG_CPU_BOOST          = 0xb0050000;
 const uint32_t INVOKER_MSG_END                = 0xdead0000;
 const uint32_t INVOKER_MSG_PID                = 0x1d1d0000;
 const uint32_t INVOKER_MSG_SPLASH             = 0x5b1a0000;
 const uint32_t INVOKER_MSG_LANDSCAPE_SPLASH   = 0x5b120000;
 const uint32_t INVOKER_MSG_EXIT               = 0xe4170000;
 const uint32_t INVOKER_MSG_ACK                = 0x600d0000;
+
+/* Batch launch: the magic carries INVOKER_MSG_MAGIC_OPTION_BATCH and
+ * INVOKER_MSG_BATCH follows it instead of the application name. It is followed by the number of applications, an
+ * optional INVOKER_MSG_IO shared by all of them, one INVOKER_MSG_BATCH_ENTRY
+ * per application and finally INVOKER_MSG_END. Each entry carries its byte
+ * size and the usual per-application messages starting with INVOKER_MSG_NAME,
+ * excluding INVOKER_MSG_IO and INVOKER_MSG_END. Launched applications are
+ * reported back with INVOKER_MSG_BATCH_PID and INVOKER_MSG_BATCH_EXIT, both
+ * followed by the index of the entry and the pid or exit status. */
+const uint32_t INVOKER_MSG_BATCH              = 0xba7c0000;
+const uint32_t INVOKER_MSG_BATCH_ENTRY        = 0xba7e0000;
+const uint32_t INVOKER_MSG_BATCH_PID          = 0xba7d0000;
+const uint32_t INVOKER_MSG_BATCH_EXIT         = 0xba7f0000;
+const uint32_t INVOKER_BATCH_MAX_ENTRIES      = 64;
+
+/* Limits of a launch request enforced by the daemon */
+const uint32_t INVOKER_ARGS_MAX               = 1023;
+const uint32_t INVOKER_ENV_MAX                = 1023;
+const uint32_t INVOKER_STR_LEN_MAX            = 4096; /* including the terminating zero */
+const uint32_t INVOKER_CPU_BOOST_MAX_MS       = 5000;
+
+/* Capabilities: the daemon publishes a struct invoker_caps in a file named
+ * after the booster socket with INVOKER_CAPS_SUFFIX appended. Invokers read
+ * it before connecting to find out which protocol features they can use.
+ * A missing file means a daemon without any of the features below. */
+#define INVOKER_CAPS_SUFFIX ".caps"
+
+const uint32_t INVOKER_CAPS_MAGIC              = 0xca950000;
+const uint32_t INVOKER_CAPS_FEATURE_NO_ACK     = 0x00000001;
+const uint32_t INVOKER_CAPS_FEATURE_BATCH      = 0x00000002;
+const uint32_t INVOKER_CAPS_FEATURE_BACKGROUND = 0x00000004;
+const uint32_t INVOKER_CAPS_FEATURE_CPU_BOOST  = 0x00000008;
+
+struct invoker_caps
+{
+    uint32_t magic;       /* INVOKER_CAPS_MAGIC | INVOKER_MSG_MAGIC_VERSION */
+    uint32_t features;    /* INVOKER_CAPS_FEATURE_* */
+    uint32_t args_max;    /* INVOKER_ARGS_MAX */
+    uint32_t env_max;     /* INVOKER_ENV_MAX */
+    uint32_t str_len_max; /* INVOKER_STR_LEN_MAX */
+    uint32_t batch_max;   /* INVOKER_BATCH_MAX_ENTRIES */
+};
+
 // not used (Harmattan security stuff)
 // const uint32_t INVOKER_MSG_BAD_CREDS          = 0x60035800;
 
@@ -69,6 +69,21 @@ static void vreport(enum report_type type, const char *msg, va_list arg)
         break;
     }
 
+    // Debug and info messages have no prefix, so they are
+    // formatted straight to the output without a copy
+    if (*str_type == '\0')
+    {
+        if (output == report_console)
+        {
+            printf("%s: ", PROG_NAME_INVOKER);
+            vprintf(msg, arg);
+        }
+        else if (output == report_syslog)
+            vsyslog(log_type, msg, arg);
+
+        return;
+    }
+
     vsnprintf(str, sizeof(str), msg, arg);
 
     // report errors and fatals to syslog even if it's not default output
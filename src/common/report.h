@@ -20,6 +20,8 @@
 #ifndef REPORT_H
 #define REPORT_H
 
+#include "loglevel.h"
+
 #ifdef __GNUC__
 #define ATTR_NORET __attribute__((noreturn))
 #else
@@ -44,14 +46,14 @@ extern void report_set_output(enum report_output new_output);
 extern void report(enum report_type type, const char *msg, ...);
 
 #ifndef DEBUG_LOGGING_DISABLED
-#define debug(msg, ...) report(report_debug, msg, ##__VA_ARGS__)
+#define debug(msg, ...) LOGLEVEL_DEBUG_CALL(1, report(report_debug, msg, ##__VA_ARGS__))
 #else
-#define debug(...)
+#define debug(...) do { } while (0)
 #endif
 
-#define info(msg, ...) report(report_info, msg, ##__VA_ARGS__)
-#define warning(msg, ...) report(report_warning, msg, ##__VA_ARGS__)
-#define error(msg, ...) report(report_error, msg, ##__VA_ARGS__)
+#define info(msg, ...) LOGLEVEL_INFO_CALL(1, report(report_info, msg, ##__VA_ARGS__))
+#define warning(msg, ...) LOGLEVEL_WARNING_CALL(1, report(report_warning, msg, ##__VA_ARGS__))
+#define error(msg, ...) LOGLEVEL_ERROR_CALL(1, report(report_error, msg, ##__VA_ARGS__))
 
 extern void ATTR_NORET die(int status, const char *msg, ...);
 
@@ -0,0 +1,94 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef SDT_H
+#define SDT_H
+
+/* Minimal static tracepoints in the SystemTap SDT v3 note format that perf,
+ * bpftrace and systemtap read, so that no <sys/sdt.h> is needed to build.
+ * A probe is a nop and a .note.stapsdt entry giving its address and where
+ * its arguments are. Every argument is passed as a signed long: integers
+ * are sign extended and pointers, such as strings, are read as addresses.
+ * On other architectures the probes compile to nothing. */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__arm__)
+
+#define SDT_ENABLED 1
+
+#if __SIZEOF_POINTER__ == 8
+#define SDT_ASM_ADDR ".8byte"
+#else
+#define SDT_ASM_ADDR ".4byte"
+#endif
+
+/* Where the compiler may keep an argument, the same as <sys/sdt.h> */
+#ifdef __arm__
+#define SDT_ARG_CONSTRAINT "g"
+#else
+#define SDT_ARG_CONSTRAINT "nor"
+#endif
+
+/* The note is followed by the comdat .stapsdt.base section, which lets
+ * tracers correct the probe address for prelinking. The argument
+ * description is "-<size>@<operand>" for each argument. */
+#define SDT_NOTE(provider, name, args)                                          \
+    "990: nop\n"                                                                \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                               \
+    ".balign 4\n"                                                               \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                          \
+    "991: .asciz \"stapsdt\"\n"                                                 \
+    "992: .balign 4\n"                                                          \
+    "993: " SDT_ASM_ADDR " 990b\n"                                              \
+    SDT_ASM_ADDR " _.stapsdt.base\n"                                            \
+    SDT_ASM_ADDR " 0\n"                                                         \
+    ".asciz \"" #provider "\"\n"                                                \
+    ".asciz \"" #name "\"\n"                                                    \
+    ".asciz \"" args "\"\n"                                                     \
+    "994: .balign 4\n"                                                          \
+    ".popsection\n"                                                             \
+    ".ifndef _.stapsdt.base\n"                                                  \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"     \
+    ".weak _.stapsdt.base\n"                                                    \
+    ".hidden _.stapsdt.base\n"                                                  \
+    "_.stapsdt.base: .space 1\n"                                                \
+    ".size _.stapsdt.base, 1\n"                                                 \
+    ".popsection\n"                                                             \
+    ".endif\n"
+
+#define SDT_PROBE0(provider, name) \
+    __asm__ __volatile__ (SDT_NOTE(provider, name, ""))
+
+#define SDT_PROBE1(provider, name, a1)                                          \
+    __asm__ __volatile__ (SDT_NOTE(provider, name, "%n0@%1")                    \
+                          :: "n" (sizeof(long)), SDT_ARG_CONSTRAINT ((long)(a1)))
+
+#define SDT_PROBE2(provider, name, a1, a2)                                      \
+    __asm__ __volatile__ (SDT_NOTE(provider, name, "%n0@%1 %n0@%2")             \
+                          :: "n" (sizeof(long)), SDT_ARG_CONSTRAINT ((long)(a1)), \
+                             SDT_ARG_CONSTRAINT ((long)(a2)))
+
+#else
+
+#define SDT_PROBE0(provider, name) do { } while (0)
+#define SDT_PROBE1(provider, name, a1) do { } while (0)
+#define SDT_PROBE2(provider, name, a1, a2) do { } while (0)
+
+#endif
+
+#endif
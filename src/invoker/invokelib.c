@@ -17,6 +17,7 @@
 **
 ****************************************************************************/
 
+#include <errno.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -32,6 +33,25 @@ void invoke_send_msg(int fd, uint32_t msg)
     write(fd, &msg, sizeof(msg));
 }
 
+bool invoke_send_data(int fd, const void *data, size_t size)
+{
+    const char *p = data;
+    while (size > 0)
+    {
+        ssize_t numWritten = write(fd, p, size);
+        if (numWritten == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            debug("%s: Error writing data: %s\n", __FUNCTION__, strerror(errno));
+            return false;
+        }
+        p += numWritten;
+        size -= numWritten;
+    }
+    return true;
+}
+
 bool invoke_recv_msg(int fd, uint32_t *msg)
 {
     uint32_t  readBuf = 0;
@@ -75,3 +95,44 @@ void invoke_send_str(int fd, char *str)
     }
 }
 
+static void invoke_buffer_append(struct invoke_buffer *buf, const void *data, size_t size)
+{
+    if (buf->size + size > buf->capacity)
+    {
+        size_t capacity = buf->capacity ? buf->capacity : 256;
+        while (capacity < buf->size + size)
+            capacity *= 2;
+
+        buf->data = realloc(buf->data, capacity);
+        if (!buf->data)
+            die(1, "Out of memory\n");
+
+        buf->capacity = capacity;
+    }
+
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+}
+
+void invoke_buffer_msg(struct invoke_buffer *buf, uint32_t msg)
+{
+    invoke_buffer_append(buf, &msg, sizeof(msg));
+}
+
+void invoke_buffer_str(struct invoke_buffer *buf, const char *str)
+{
+    if (str)
+    {
+        uint32_t size = strlen(str) + 1;
+        invoke_buffer_msg(buf, size);
+        invoke_buffer_append(buf, str, size);
+    }
+}
+
+void invoke_buffer_free(struct invoke_buffer *buf)
+{
+    free(buf->data);
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+}
@@ -21,12 +21,26 @@
 #define INVOKELIB_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 void invoke_send_msg(int fd, uint32_t msg);
+bool invoke_send_data(int fd, const void *data, size_t size);
 bool invoke_recv_msg(int fd, uint32_t *msg);
 
 void invoke_send_str(int fd, char *str);
 
+// Growing buffer for messages that are sent in one go
+struct invoke_buffer
+{
+    char   *data;
+    size_t  size;
+    size_t  capacity;
+};
+
+void invoke_buffer_msg(struct invoke_buffer *buf, uint32_t msg);
+void invoke_buffer_str(struct invoke_buffer *buf, const char *str);
+void invoke_buffer_free(struct invoke_buffer *buf);
+
 // Existence of the test mode control file is checked
 // to enable test mode.
 #define TEST_MODE_CONTROL_FILE   "/root/.itm"
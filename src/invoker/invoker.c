@@ -40,6 +40,7 @@
 #include <fcntl.h>
 
 #include "report.h"
+#include "probes.h"
 #include "protocol.h"
 #include "invokelib.h"
 #include "search.h"
@@ -55,9 +56,15 @@ static const unsigned int RESPAWN_DELAY     = 3;
 static const unsigned int MIN_RESPAWN_DELAY = 0;
 static const unsigned int MAX_RESPAWN_DELAY = 10;
 
+// Default duration of a launch-time CPU boost in milliseconds
+static const unsigned int CPU_BOOST_DURATION = 500;
+
 static const unsigned char EXIT_STATUS_APPLICATION_CONNECTION_LOST = 0xfa;
 static const unsigned char EXIT_STATUS_APPLICATION_NOT_FOUND = 0x7f;
 
+// Maximum number of arguments of one application in a batch file
+#define BATCH_MAX_ARGS 256
+
 // Environment
 extern char ** environ;
 
@@ -177,39 +184,110 @@ static bool invoke_recv_ack(int fd)
     return true;
 }
 
-// Inits a socket connection for the given application type
-static int invoker_init(const char *app_type)
+// Builds the socket address for the given application type
+static void invoker_socket_addr(const char *app_type, struct sockaddr_un *sun)
 {
-    int fd;
-    struct sockaddr_un sun;
-
-    fd = socket(PF_UNIX, SOCK_STREAM, 0);
-    if (fd < 0)
-    {
-        error("Failed to open invoker socket.\n");
-        return -1;
-    }
-
-    sun.sun_family = AF_UNIX;
-    int maxSize = sizeof(sun.sun_path) - 1;
+    sun->sun_family = AF_UNIX;
+    int maxSize = sizeof(sun->sun_path) - 1;
  
     const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
     const char *subpath = "/mapplauncherd/";
     const int subpathLen = strlen(subpath);
 
     if (runtimeDir && *runtimeDir)
-        strncpy(sun.sun_path, runtimeDir, maxSize - subpathLen);
+        strncpy(sun->sun_path, runtimeDir, maxSize - subpathLen);
     else
-        strncpy(sun.sun_path, "/tmp", maxSize - subpathLen);
+        strncpy(sun->sun_path, "/tmp", maxSize - subpathLen);
 
-    sun.sun_path[maxSize - subpathLen] = 0;
-    strcat(sun.sun_path, subpath);
+    sun->sun_path[maxSize - subpathLen] = 0;
+    strcat(sun->sun_path, subpath);
 
-    maxSize -= strlen(sun.sun_path);
+    maxSize -= strlen(sun->sun_path);
     if (maxSize < strlen(app_type) || strchr(app_type, '/'))
         die(1, "Invalid type of application: %s\n", app_type);
 
-    strcat(sun.sun_path, app_type);
+    strcat(sun->sun_path, app_type);
+}
+
+// Reads the capabilities published by the launcher for the given
+// application type. A launcher that doesn't publish them supports
+// none of the optional features and has the traditional limits.
+static void invoker_read_caps(const char *app_type, struct invoker_caps *caps)
+{
+    struct sockaddr_un sun;
+    char path[sizeof(sun.sun_path) + sizeof(INVOKER_CAPS_SUFFIX)];
+
+    invoker_socket_addr(app_type, &sun);
+    snprintf(path, sizeof(path), "%s%s", sun.sun_path, INVOKER_CAPS_SUFFIX);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1 || read(fd, caps, sizeof(*caps)) != sizeof(*caps) ||
+        caps->magic != (INVOKER_CAPS_MAGIC | INVOKER_MSG_MAGIC_VERSION))
+    {
+        debug("No capabilities in %s\n", path);
+        caps->magic = 0;
+        caps->features = 0;
+        caps->args_max = INVOKER_ARGS_MAX;
+        caps->env_max = INVOKER_ENV_MAX;
+        caps->str_len_max = INVOKER_STR_LEN_MAX;
+        caps->batch_max = 0;
+    }
+
+    if (fd != -1)
+        close(fd);
+}
+
+// Drops the options the launcher doesn't support
+static uint32_t invoker_supported_options(const struct invoker_caps *caps, uint32_t options)
+{
+    if (!(caps->features & INVOKER_CAPS_FEATURE_NO_ACK))
+        options &= ~INVOKER_MSG_MAGIC_OPTION_NO_ACK;
+
+    if (!(caps->features & INVOKER_CAPS_FEATURE_BACKGROUND))
+        options &= ~INVOKER_MSG_MAGIC_OPTION_BACKGROUND;
+
+    return options;
+}
+
+// Checks that the launch request fits in the limits of the launcher
+static bool invoker_check_limits(const struct invoker_caps *caps, int prog_argc, char **prog_argv)
+{
+    int i, n_vars;
+
+    for (n_vars = 0; environ[n_vars] != NULL; n_vars++) ;
+
+    if ((uint32_t)prog_argc > caps->args_max || (uint32_t)n_vars > caps->env_max)
+        return false;
+
+    for (i = 0; i < prog_argc; i++)
+    {
+        if (strlen(prog_argv[i]) >= caps->str_len_max)
+            return false;
+    }
+
+    for (i = 0; i < n_vars; i++)
+    {
+        if (strlen(environ[i]) >= caps->str_len_max)
+            return false;
+    }
+
+    return true;
+}
+
+// Inits a socket connection for the given application type
+static int invoker_init(const char *app_type)
+{
+    int fd;
+    struct sockaddr_un sun;
+
+    fd = socket(PF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        error("Failed to open invoker socket.\n");
+        return -1;
+    }
+
+    invoker_socket_addr(app_type, &sun);
 
     if (connect(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0)
     {
@@ -310,6 +388,14 @@ static void invoker_send_delay(int fd, int delay)
     invoke_send_msg(fd, delay);
 }
 
+// Sends launch-time uclamp.min and its duration
+static void invoker_send_cpu_boost(int fd, unsigned int percent, unsigned int duration)
+{
+    invoke_send_msg(fd, INVOKER_MSG_CPU_BOOST);
+    invoke_send_msg(fd, percent);
+    invoke_send_msg(fd, duration);
+}
+
 // Sends UID and GID
 static void invoker_send_ids(int fd, int uid, int gid)
 {
@@ -375,18 +461,21 @@ static void invoker_send_io(int fd)
     return;
 }
 
-// Sends the END message
-static void invoker_send_end(int fd)
+// Sends the END message and waits for the ACK unless the launcher
+// was told not to send one
+static void invoker_send_end(int fd, uint32_t options)
 {
     invoke_send_msg(fd, INVOKER_MSG_END);
-    invoke_recv_ack(fd);
 
+    if (!(options & INVOKER_MSG_MAGIC_OPTION_NO_ACK))
+        invoke_recv_ack(fd);
 }
 
 // Prints the usage and exits with given status
 static void usage(int status)
 {
-    printf("\nUsage: %s [options] [--type=TYPE] [file] [args]\n\n"
+    printf("\nUsage: %s [options] [--type=TYPE] [file] [args]\n"
+           "       %s [options] --type=TYPE --batch FILE\n\n"
            "Launch applications compiled as a shared library (-shared) or\n"
            "a position independent executable (-pie) through mapplauncherd.\n\n"
            "TYPE chooses the type of booster used. Qt-booster may be used to\n"
@@ -402,6 +491,10 @@ static void usage(int status)
            "                         (default %d, max %d).\n"
            "  -w, --wait-term        Wait for launched process to terminate (default).\n"
            "  -n, --no-wait          Do not wait for launched process to terminate.\n"
+           "  -F, --fire-and-forget  Exit as soon as the launch request has been sent,\n"
+           "                         without waiting for the launcher to acknowledge it.\n"
+           "                         Errors are only reported to the system log.\n"
+           "                         Implies --no-wait.\n"
            "  -G, --global-syms      Places symbols in the application binary and its\n"
            "                         libraries to the global scope.\n"
            "                         See RTLD_GLOBAL in the dlopen manual page.\n"
@@ -410,10 +503,20 @@ static void usage(int status)
            "                         if already launched.\n"
            "  -o, --keep-oom-score   Notify invoker that the launched process should inherit oom_score_adj\n"
            "                         from the booster. The score is reset to 0 normally.\n"
+           "  -b, --background       Launch a background service. Launches queued in the\n"
+           "                         launcher without this option go first.\n"
+           "  -u, --cpu-boost PERCENT[:MS]\n"
+           "                         Ask the scheduler to run the application at least at\n"
+           "                         PERCENT of the capacity of the fastest core (uclamp.min)\n"
+           "                         for the first MS milliseconds (default %u, max %u).\n"
+           "  -B, --batch FILE       Launch all applications listed in FILE through a single\n"
+           "                         connection. Each line holds a program and its arguments.\n"
+           "                         Waits for all of them unless --no-wait is given.\n"
            "  -T, --test-mode        Invoker test mode. Also control file in root home should be in place.\n"
            "  -h, --help             Print this help.\n\n"
            "Example: %s --type=qt5 /usr/bin/helloworld\n\n",
-           PROG_NAME_INVOKER, EXIT_DELAY, RESPAWN_DELAY, MAX_RESPAWN_DELAY, PROG_NAME_INVOKER);
+           PROG_NAME_INVOKER, PROG_NAME_INVOKER, EXIT_DELAY, RESPAWN_DELAY, MAX_RESPAWN_DELAY,
+           CPU_BOOST_DURATION, INVOKER_CPU_BOOST_MAX_MS, PROG_NAME_INVOKER);
 
     exit(status);
 }
@@ -442,6 +545,32 @@ static unsigned int get_delay(char *delay_arg, char *param_name,
     return delay;
 }
 
+// Parses PERCENT[:MS] of --cpu-boost
+static void get_cpu_boost(char *boost_arg, int *percent, unsigned int *duration)
+{
+    char *end = NULL;
+    errno = 0;
+    unsigned long value = strtoul(boost_arg, &end, 10);
+    unsigned long ms = CPU_BOOST_DURATION;
+
+    if (!errno && end != boost_arg && *end == ':')
+    {
+        char *ms_arg = end + 1;
+        ms = strtoul(ms_arg, &end, 10);
+        if (end == ms_arg)
+            errno = EINVAL;
+    }
+
+    if (errno || *end || value > 100 || ms == 0 || ms > INVOKER_CPU_BOOST_MAX_MS)
+    {
+        report(report_error, "Wrong value of cpu-boost parameter: %s\n", boost_arg);
+        usage(1);
+    }
+
+    *percent = value;
+    *duration = ms;
+}
+
 static int wait_for_launched_process_to_exit(int socket_fd, bool wait_term)
 {
     int status = 0;
@@ -535,7 +664,8 @@ static int wait_for_launched_process_to_exit(int socket_fd, bool wait_term)
 
 // "normal" invoke through a socket connection
 static int invoke_remote(int socket_fd, int prog_argc, char **prog_argv, char *prog_name,
-                         uint32_t magic_options, bool wait_term, unsigned int respawn_delay)
+                         uint32_t magic_options, bool wait_term, unsigned int respawn_delay,
+                         int cpu_boost, unsigned int cpu_boost_ms)
 {
     // Get process priority
     errno = 0;
@@ -547,16 +677,20 @@ static int invoke_remote(int socket_fd, int prog_argc, char **prog_argv, char *p
 
     // Connection with launcher process is established,
     // send the data.
+    LAUNCHER_PROBE1(invoker_send_start, prog_argv[0]);
     invoker_send_magic(socket_fd, magic_options);
     invoker_send_name(socket_fd, prog_name);
     invoker_send_exec(socket_fd, prog_argv[0]);
     invoker_send_args(socket_fd, prog_argc, prog_argv);
     invoker_send_prio(socket_fd, prog_prio);
     invoker_send_delay(socket_fd, respawn_delay);
+    if (cpu_boost >= 0)
+        invoker_send_cpu_boost(socket_fd, cpu_boost, cpu_boost_ms);
     invoker_send_ids(socket_fd, getuid(), getgid());
     invoker_send_io(socket_fd);
     invoker_send_env(socket_fd);
-    invoker_send_end(socket_fd);
+    invoker_send_end(socket_fd, magic_options);
+    LAUNCHER_PROBE1(invoker_send_end, prog_argv[0]);
 
     if (prog_name)
     {
@@ -567,6 +701,240 @@ static int invoke_remote(int socket_fd, int prog_argc, char **prog_argv, char *p
     return exit_status;
 }
 
+// Checks that the program exists and is a file
+static bool check_program(const char *prog_name)
+{
+    struct stat file_stat;
+
+    if (stat(prog_name, &file_stat))
+    {
+        report(report_error, "%s: not found\n", prog_name);
+        return false;
+    }
+
+    if (!S_ISREG(file_stat.st_mode) && !S_ISLNK(file_stat.st_mode))
+    {
+        report(report_error, "%s: not a file\n", prog_name);
+        return false;
+    }
+
+    return true;
+}
+
+// Adds one application of a batch file to buf. Each line of the file
+// holds a program followed by its arguments, separated by whitespace.
+static bool batch_add_entry(struct invoke_buffer *buf, char *line,
+                            const struct invoker_caps *caps,
+                            int prog_prio, unsigned int respawn_delay)
+{
+    char *prog_argv[BATCH_MAX_ARGS];
+    int prog_argc = 0;
+    char *saveptr = NULL;
+    char *token = strtok_r(line, " \t\n", &saveptr);
+
+    while (token && prog_argc < BATCH_MAX_ARGS)
+    {
+        prog_argv[prog_argc++] = token;
+        token = strtok_r(NULL, " \t\n", &saveptr);
+    }
+
+    if (token)
+    {
+        report(report_error, "%s: too many arguments\n", prog_argv[0]);
+        return false;
+    }
+
+    char *prog_name = search_program(prog_argv[0]);
+    if (!check_program(prog_name))
+    {
+        free(prog_name);
+        return false;
+    }
+    prog_argv[0] = prog_name;
+
+    if (!invoker_check_limits(caps, prog_argc, prog_argv))
+    {
+        report(report_error, "%s: exceeds the limits of the launcher\n", prog_name);
+        free(prog_name);
+        return false;
+    }
+
+    int i, n_vars;
+    for (n_vars = 0; environ[n_vars] != NULL; n_vars++) ;
+
+    invoke_buffer_msg(buf, INVOKER_MSG_NAME);
+    invoke_buffer_str(buf, prog_name);
+    invoke_buffer_msg(buf, INVOKER_MSG_EXEC);
+    invoke_buffer_str(buf, prog_name);
+    invoke_buffer_msg(buf, INVOKER_MSG_ARGS);
+    invoke_buffer_msg(buf, prog_argc);
+    for (i = 0; i < prog_argc; i++)
+        invoke_buffer_str(buf, prog_argv[i]);
+    invoke_buffer_msg(buf, INVOKER_MSG_PRIO);
+    invoke_buffer_msg(buf, prog_prio);
+    invoke_buffer_msg(buf, INVOKER_MSG_DELAY);
+    invoke_buffer_msg(buf, respawn_delay);
+    invoke_buffer_msg(buf, INVOKER_MSG_IDS);
+    invoke_buffer_msg(buf, getuid());
+    invoke_buffer_msg(buf, getgid());
+    invoke_buffer_msg(buf, INVOKER_MSG_ENV);
+    invoke_buffer_msg(buf, n_vars);
+    for (i = 0; i < n_vars; i++)
+        invoke_buffer_str(buf, environ[i]);
+
+    free(prog_name);
+    return true;
+}
+
+// Reads the applications of a batch file. Empty lines and
+// lines starting with '#' are ignored.
+static int batch_read_file(const char *batch_file, struct invoke_buffer *entries,
+                           const struct invoker_caps *caps, unsigned int respawn_delay)
+{
+    FILE *file = fopen(batch_file, "r");
+    if (!file)
+    {
+        report(report_error, "%s: %s\n", batch_file, strerror(errno));
+        return -1;
+    }
+
+    errno = 0;
+    int prog_prio = getpriority(PRIO_PROCESS, 0);
+    if (errno && prog_prio < 0)
+    {
+        prog_prio = 0;
+    }
+
+    uint32_t max_entries = INVOKER_BATCH_MAX_ENTRIES;
+    if (caps->batch_max < max_entries)
+        max_entries = caps->batch_max;
+
+    int count = 0;
+    char *line = NULL;
+    size_t len = 0;
+
+    while (getline(&line, &len, file) != -1)
+    {
+        char *start = line + strspn(line, " \t\n");
+        if (*start == '\0' || *start == '#')
+            continue;
+
+        if ((uint32_t)count == max_entries)
+        {
+            report(report_error, "%s: more than %u applications\n",
+                   batch_file, max_entries);
+            count = -1;
+            break;
+        }
+
+        memset(&entries[count], 0, sizeof(entries[count]));
+        if (!batch_add_entry(&entries[count], start, caps, prog_prio, respawn_delay))
+        {
+            invoke_buffer_free(&entries[count]);
+            count = -1;
+            break;
+        }
+        count++;
+    }
+
+    free(line);
+    fclose(file);
+
+    if (count == 0)
+        report(report_error, "%s: no applications\n", batch_file);
+
+    return count;
+}
+
+// Launches all applications of a batch file through a single connection.
+// Returns the first non-zero exit status of the applications.
+static int invoke_batch(const char *batch_file, const char *app_type,
+                        uint32_t magic_options, bool wait_term, unsigned int respawn_delay)
+{
+    struct invoker_caps caps;
+    invoker_read_caps(app_type, &caps);
+    if (!(caps.features & INVOKER_CAPS_FEATURE_BATCH))
+        die(1, "Booster %s doesn't support batch launches.\n", app_type);
+
+    magic_options = invoker_supported_options(&caps, magic_options);
+
+    struct invoke_buffer entries[INVOKER_BATCH_MAX_ENTRIES];
+    int count = batch_read_file(batch_file, entries, &caps, respawn_delay);
+    if (count <= 0)
+        return EXIT_STATUS_APPLICATION_NOT_FOUND;
+
+    int i;
+    int fd = invoker_init(app_type);
+    if (fd == -1)
+    {
+        for (i = 0; i < count; i++)
+            invoke_buffer_free(&entries[i]);
+        die(1, "Booster %s is not available.\n", app_type);
+    }
+
+    LAUNCHER_PROBE1(invoker_send_start, batch_file);
+    invoker_send_magic(fd, magic_options | INVOKER_MSG_MAGIC_OPTION_BATCH);
+    invoke_send_msg(fd, INVOKER_MSG_BATCH);
+    invoke_send_msg(fd, count);
+    invoker_send_io(fd);
+
+    for (i = 0; i < count; i++)
+    {
+        invoke_send_msg(fd, INVOKER_MSG_BATCH_ENTRY);
+        invoke_send_msg(fd, entries[i].size);
+        if (!invoke_send_data(fd, entries[i].data, entries[i].size))
+        {
+            error("Can't send batch entry %d to launcher process.\n", i);
+            for (; i < count; i++)
+                invoke_buffer_free(&entries[i]);
+            close(fd);
+            return EXIT_STATUS_APPLICATION_CONNECTION_LOST;
+        }
+        invoke_buffer_free(&entries[i]);
+    }
+
+    invoker_send_end(fd, magic_options);
+    LAUNCHER_PROBE1(invoker_send_end, batch_file);
+
+    // Without waiting the PIDs are enough, otherwise
+    // collect the exit statuses of all applications
+    int status = 0;
+    int remaining = (magic_options & INVOKER_MSG_MAGIC_OPTION_NO_ACK) ? 0 : count;
+
+    while (remaining > 0)
+    {
+        uint32_t action, index, value;
+        if (!invoke_recv_msg(fd, &action) || !invoke_recv_msg(fd, &index) ||
+            !invoke_recv_msg(fd, &value))
+        {
+            error("Connection with launcher process lost.\n");
+            status = EXIT_STATUS_APPLICATION_CONNECTION_LOST;
+            break;
+        }
+
+        if (action == INVOKER_MSG_BATCH_PID)
+        {
+            debug("Application %u has pid %u\n", index, value);
+            if (!wait_term)
+                remaining--;
+        }
+        else if (action == INVOKER_MSG_BATCH_EXIT)
+        {
+            debug("Application %u exited with %u\n", index, value);
+            if (value && !status)
+                status = value;
+            remaining--;
+        }
+        else
+        {
+            die(1, "Received a bad message id (%08x)\n", action);
+        }
+    }
+
+    close(fd);
+    return status;
+}
+
 static void invoke_fallback(char **prog_argv, char *prog_name, bool wait_term)
 {
     // Connection with launcher is broken,
@@ -600,7 +968,7 @@ static void invoke_fallback(char **prog_argv, char *prog_name, bool wait_term)
 // Invokes the given application
 static int invoke(int prog_argc, char **prog_argv, char *prog_name,
                   const char *app_type, uint32_t magic_options, bool wait_term, unsigned int respawn_delay,
-                  bool test_mode)
+                  int cpu_boost, unsigned int cpu_boost_ms, bool test_mode)
 {
     int status = 0;
     if (prog_name && prog_argv)
@@ -612,6 +980,16 @@ static int invoke(int prog_argc, char **prog_argv, char *prog_name,
             info("Invoker test mode is not enabled.\n");
         }
 
+        // Requests the launcher would refuse are launched without it
+        struct invoker_caps caps;
+        invoker_read_caps(app_type, &caps);
+        if (!invoker_check_limits(&caps, prog_argc, prog_argv))
+        {
+            warning("Launch request exceeds the limits of booster %s.\n", app_type);
+            invoke_fallback(prog_argv, prog_argv[0], wait_term);
+            return status;
+        }
+
         // This is a fallback if connection with the launcher
         // process is broken       
         int fd = invoker_init(app_type);
@@ -629,14 +1007,23 @@ static int invoke(int prog_argc, char **prog_argv, char *prog_name,
             else
             {
                 warning("Booster %s is not available. Falling back to generic.\n", app_type);
-                invoke(prog_argc, prog_argv, prog_argv[0], "generic", magic_options, wait_term, respawn_delay, test_mode);
+                invoke(prog_argc, prog_argv, prog_argv[0], "generic", magic_options, wait_term, respawn_delay,
+                       cpu_boost, cpu_boost_ms, test_mode);
             }
         }
         // "normal" invoke through a socket connetion
         else
         {
+            // Older launchers don't know the boost
+            if (cpu_boost >= 0 && !(caps.features & INVOKER_CAPS_FEATURE_CPU_BOOST))
+            {
+                warning("Booster %s doesn't support CPU boosts, launching without one.\n", app_type);
+                cpu_boost = -1;
+            }
+
             status = invoke_remote(fd, prog_argc, prog_argv, prog_name,
-                                   magic_options, wait_term, respawn_delay);
+                                   invoker_supported_options(&caps, magic_options),
+                                   wait_term, respawn_delay, cpu_boost, cpu_boost_ms);
             close(fd);
         }
     }
@@ -652,9 +1039,11 @@ int main(int argc, char *argv[])
     bool          wait_term     = true;
     unsigned int  delay         = EXIT_DELAY;
     unsigned int  respawn_delay = RESPAWN_DELAY;
+    int           cpu_boost     = -1;
+    unsigned int  cpu_boost_ms  = CPU_BOOST_DURATION;
     char        **prog_argv     = NULL;
     char         *prog_name     = NULL;
-    struct stat   file_stat;
+    const char   *batch_file    = NULL;
     bool test_mode = false;
 
     // wait-term parameter by default
@@ -676,6 +1065,7 @@ int main(int argc, char *argv[])
         {"help",             no_argument,       NULL, 'h'},
         {"wait-term",        no_argument,       NULL, 'w'},
         {"no-wait",          no_argument,       NULL, 'n'},
+        {"fire-and-forget",  no_argument,       NULL, 'F'},
         {"global-syms",      no_argument,       NULL, 'G'},
         {"deep-syms",        no_argument,       NULL, 'D'},
         {"single-instance",  no_argument,       NULL, 's'},
@@ -683,6 +1073,9 @@ int main(int argc, char *argv[])
         {"daemon-mode",      no_argument,       NULL, 'o'}, // Legacy alias
         {"test-mode",        no_argument,       NULL, 'T'},
         {"type",             required_argument, NULL, 't'},
+        {"batch",            required_argument, NULL, 'B'},
+        {"background",       no_argument,       NULL, 'b'},
+        {"cpu-boost",        required_argument, NULL, 'u'},
         {"delay",            required_argument, NULL, 'd'},
         {"respawn",          required_argument, NULL, 'r'},
         {"splash",           required_argument, NULL, 'S'},
@@ -693,7 +1086,7 @@ int main(int argc, char *argv[])
     // Parse options
     // TODO: Move to a function
     int opt;
-    while ((opt = getopt_long(argc, argv, "hcwnGDsoTd:t:r:S:L:", longopts, NULL)) != -1)
+    while ((opt = getopt_long(argc, argv, "hcwnFGDsobTd:t:r:u:S:L:B:", longopts, NULL)) != -1)
     {
         switch(opt)
         {
@@ -714,6 +1107,12 @@ int main(int argc, char *argv[])
             magic_options &= (~INVOKER_MSG_MAGIC_OPTION_WAIT);
             break;
 
+        case 'F':
+            wait_term = false;
+            magic_options &= (~INVOKER_MSG_MAGIC_OPTION_WAIT);
+            magic_options |= INVOKER_MSG_MAGIC_OPTION_NO_ACK;
+            break;
+
         case 'G':
             magic_options |= INVOKER_MSG_MAGIC_OPTION_DLOPEN_GLOBAL;
             break;
@@ -722,6 +1121,10 @@ int main(int argc, char *argv[])
             magic_options |= INVOKER_MSG_MAGIC_OPTION_DLOPEN_DEEP;
             break;
 
+        case 'b':
+            magic_options |= INVOKER_MSG_MAGIC_OPTION_BACKGROUND;
+            break;
+
         case 'T':
             test_mode = true;
             break;
@@ -730,6 +1133,10 @@ int main(int argc, char *argv[])
             app_type = optarg;
             break;
 
+        case 'B':
+            batch_file = optarg;
+            break;
+
         case 'd':
             delay = get_delay(optarg, "delay", MIN_EXIT_DELAY, MAX_EXIT_DELAY);
             break;
@@ -739,6 +1146,10 @@ int main(int argc, char *argv[])
                                       MIN_RESPAWN_DELAY, MAX_RESPAWN_DELAY);
             break;
 
+        case 'u':
+            get_cpu_boost(optarg, &cpu_boost, &cpu_boost_ms);
+            break;
+
         case 's':
             magic_options |= INVOKER_MSG_MAGIC_OPTION_SINGLE_INSTANCE;
             break;
@@ -753,6 +1164,44 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (batch_file)
+    {
+        if (optind < argc)
+        {
+            report(report_error, "Application can't be given with --batch.\n");
+            usage(1);
+        }
+
+        if (!app_type)
+        {
+            report(report_error, "Application type must be specified with --type.\n");
+            usage(1);
+        }
+
+        if (magic_options & INVOKER_MSG_MAGIC_OPTION_SINGLE_INSTANCE)
+        {
+            report(report_error, "--single-instance can't be used with --batch.\n");
+            usage(1);
+        }
+
+        if (cpu_boost >= 0)
+        {
+            report(report_error, "--cpu-boost can't be used with --batch.\n");
+            usage(1);
+        }
+
+        info("Invoking batch: '%s'\n", batch_file);
+        int ret_val = invoke_batch(batch_file, app_type, magic_options, wait_term, respawn_delay);
+
+        if (delay)
+        {
+            debug("Delaying exit for %d seconds..\n", delay);
+            sleep(delay);
+        }
+
+        return ret_val;
+    }
+
     // Option processing stops as soon as application name is encountered
     if (optind < argc)
     {
@@ -772,17 +1221,9 @@ int main(int argc, char *argv[])
         usage(1);
     }
 
-    // Check if application exists
-    if (stat(prog_name, &file_stat))
-    {
-        report(report_error, "%s: not found\n", prog_name);
-        return EXIT_STATUS_APPLICATION_NOT_FOUND;
-    }
-
-    // Check that 
-    if (!S_ISREG(file_stat.st_mode) && !S_ISLNK(file_stat.st_mode))
+    // Check if application exists and is a file
+    if (!check_program(prog_name))
     {
-        report(report_error, "%s: not a file\n", prog_name);
         return EXIT_STATUS_APPLICATION_NOT_FOUND;
     }
 
@@ -813,7 +1254,8 @@ int main(int argc, char *argv[])
 
     // Send commands to the launcher daemon
     info("Invoking execution: '%s'\n", prog_name);
-    int ret_val = invoke(prog_argc, prog_argv, prog_name, app_type, magic_options, wait_term, respawn_delay, test_mode);
+    int ret_val = invoke(prog_argc, prog_argv, prog_name, app_type, magic_options, wait_term, respawn_delay,
+                         cpu_boost, cpu_boost_ms, test_mode);
 
     // Sleep for delay before exiting
     if (delay)
@@ -0,0 +1,349 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "launchevents.h"
+
+#define PROG_NAME "launch-events"
+
+static const char *event_names[] = {
+    "?",
+    "received",
+    "booster-chosen",
+    "fork",
+    "main-entered",
+    "exit",
+    "respawn-started",
+    "respawn-finished",
+    "booster-stopped",
+    "queued",
+    "booster-rss",
+    "booster-pss",
+    "booster-evicted",
+    "booster-rewarmed"
+};
+
+static void usage(int status)
+{
+    printf("\nUsage: %s [options] [FILE]\n\n"
+           "Print the launch event journal of a booster daemon.\n\n"
+           "FILE is the journal to read, by default the one of the booster type\n"
+           "given with --type in $XDG_RUNTIME_DIR/mapplauncherd/.\n\n"
+           "Options:\n"
+           "  -t, --type TYPE        Booster type, the default is generic.\n"
+           "  -s, --stats            Print queue and booster memory statistics instead of the events.\n"
+           "  -h, --help             Print this help.\n\n",
+           PROG_NAME);
+
+    exit(status);
+}
+
+static const char *event_name(uint32_t type)
+{
+    if (type >= sizeof(event_names) / sizeof(event_names[0]))
+        type = 0;
+
+    return event_names[type];
+}
+
+// Formats the type specific value of event to buf
+static void format_value(const struct launch_event *event, char *buf, size_t size)
+{
+    int status = event->value;
+
+    switch (event->type)
+    {
+    case launch_event_exit:
+        if (WIFEXITED(status))
+            snprintf(buf, size, "status=%d", WEXITSTATUS(status));
+        else if (WIFSIGNALED(status))
+            snprintf(buf, size, "signal=%d", WTERMSIG(status));
+        else
+            snprintf(buf, size, "wait=%#x", status);
+        break;
+    case launch_event_received:
+    case launch_event_booster_chosen:
+        snprintf(buf, size, "conn=%d", event->value);
+        break;
+    case launch_event_fork:
+    case launch_event_respawn_started:
+        snprintf(buf, size, "delay=%d", event->value);
+        break;
+    case launch_event_booster_stopped:
+        snprintf(buf, size, "idle=%d", event->value);
+        break;
+    case launch_event_queued:
+        snprintf(buf, size, "depth=%d", event->value);
+        break;
+    case launch_event_booster_rss:
+    case launch_event_booster_pss:
+        snprintf(buf, size, "kB=%d", event->value);
+        break;
+    case launch_event_booster_evicted:
+    case launch_event_booster_rewarmed:
+        snprintf(buf, size, "psi=%d.%02d%%", event->value / 100, event->value % 100);
+        break;
+    default:
+        snprintf(buf, size, "-");
+        break;
+    }
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+#define MAX_FOOTPRINTS 16
+
+// Latest memory footprint of an idle booster of a type
+struct footprint {
+    char type[LAUNCH_EVENTS_APP_LEN + 1];
+    int rss;
+    int pss;
+};
+
+// Returns the footprint of the type of event, NULL if there are too many types
+static struct footprint *find_footprint(struct footprint *footprints, unsigned int *count,
+                                        const struct launch_event *event)
+{
+    char type[LAUNCH_EVENTS_APP_LEN + 1];
+    memcpy(type, event->app, LAUNCH_EVENTS_APP_LEN);
+    type[LAUNCH_EVENTS_APP_LEN] = '\0';
+
+    for (unsigned int i = 0; i < *count; i++)
+    {
+        if (strcmp(footprints[i].type, type) == 0)
+            return &footprints[i];
+    }
+
+    if (*count == MAX_FOOTPRINTS)
+        return NULL;
+
+    struct footprint *footprint = &footprints[(*count)++];
+    strcpy(footprint->type, type);
+    footprint->rss = footprint->pss = -1;
+    return footprint;
+}
+
+// Prints how long connections waited in the daemon queue, how long the
+// queue was and the latest memory footprint of idle boosters of each type
+static void print_stats(const struct launch_event *events, uint64_t first, uint64_t next)
+{
+    // Acceptance times by connection id, the journal can't hold more connections
+    static uint64_t received[LAUNCH_EVENTS_CAPACITY];
+    static int32_t received_id[LAUNCH_EVENTS_CAPACITY];
+    static uint64_t waits[LAUNCH_EVENTS_CAPACITY];
+    unsigned int n_waits = 0, n_queued = 0;
+    uint64_t depth_sum = 0;
+    int depth_max = 0;
+    struct footprint footprints[MAX_FOOTPRINTS], *footprint;
+    unsigned int n_footprints = 0;
+
+    for (uint64_t i = first; i < next; i++)
+    {
+        const struct launch_event *event = &events[i % LAUNCH_EVENTS_CAPACITY];
+        if (event->sequence != i + 1)
+            continue;
+
+        const unsigned int slot = (uint32_t)event->value % LAUNCH_EVENTS_CAPACITY;
+        switch (event->type)
+        {
+        case launch_event_received:
+            received[slot] = event->timestamp;
+            received_id[slot] = event->value;
+            break;
+        case launch_event_booster_chosen:
+            // Entries of a batch share the connection id of the batch
+            if (received[slot] && received_id[slot] == event->value)
+                waits[n_waits++] = event->timestamp - received[slot];
+            break;
+        case launch_event_queued:
+            n_queued++;
+            depth_sum += event->value;
+            if (event->value > depth_max)
+                depth_max = event->value;
+            break;
+        case launch_event_booster_rss:
+            if ((footprint = find_footprint(footprints, &n_footprints, event)))
+                footprint->rss = event->value;
+            break;
+        case launch_event_booster_pss:
+            if ((footprint = find_footprint(footprints, &n_footprints, event)))
+                footprint->pss = event->value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    printf("launches handed to boosters: %u\n", n_waits);
+    if (n_waits)
+    {
+        qsort(waits, n_waits, sizeof(waits[0]), compare_u64);
+
+        uint64_t sum = 0;
+        for (unsigned int i = 0; i < n_waits; i++)
+            sum += waits[i];
+
+        printf("queue wait [ms]: avg %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n",
+               sum / n_waits / 1e6,
+               waits[n_waits / 2] / 1e6,
+               waits[n_waits * 9 / 10] / 1e6,
+               waits[n_waits * 99 / 100] / 1e6,
+               waits[n_waits - 1] / 1e6);
+    }
+
+    if (n_queued)
+        printf("queue depth: avg %.2f max %d\n", (double)depth_sum / n_queued, depth_max);
+
+    for (unsigned int i = 0; i < n_footprints; i++)
+        printf("idle booster [%s] [kB]: rss %d pss %d\n",
+               footprints[i].type, footprints[i].rss, footprints[i].pss);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *type = "generic";
+    char path[4096];
+    int stats = 0;
+
+    struct option longopts[] = {
+        {"help",  no_argument,       NULL, 'h'},
+        {"type",  required_argument, NULL, 't'},
+        {"stats", no_argument,       NULL, 's'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "ht:s", longopts, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'h':
+            usage(0);
+            break;
+        case 't':
+            type = optarg;
+            break;
+        case 's':
+            stats = 1;
+            break;
+        default:
+            usage(1);
+        }
+    }
+
+    if (optind < argc)
+    {
+        snprintf(path, sizeof(path), "%s", argv[optind]);
+    }
+    else
+    {
+        const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
+        snprintf(path, sizeof(path), "%s/mapplauncherd/%s%s",
+                 runtimeDir && *runtimeDir ? runtimeDir : "/tmp", type, LAUNCH_EVENTS_SUFFIX);
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        fprintf(stderr, "%s: can't open %s: %s\n", PROG_NAME, path, strerror(errno));
+        return 1;
+    }
+
+    // Take a snapshot, the daemon keeps on writing
+    struct launch_events_header header;
+    static struct launch_event events[LAUNCH_EVENTS_CAPACITY];
+
+    if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != LAUNCH_EVENTS_MAGIC || header.capacity != LAUNCH_EVENTS_CAPACITY ||
+        read(fd, events, sizeof(events)) != sizeof(events))
+    {
+        fprintf(stderr, "%s: %s is not a launch event journal\n", PROG_NAME, path);
+        close(fd);
+        return 1;
+    }
+
+    close(fd);
+
+    uint64_t first = header.next > LAUNCH_EVENTS_CAPACITY ? header.next - LAUNCH_EVENTS_CAPACITY : 0;
+    uint64_t previous = 0;
+
+    if (stats)
+    {
+        print_stats(events, first, header.next);
+        return 0;
+    }
+
+    unsigned int incomplete = 0;
+
+    printf("%10s %14s %10s %7s %-17s %-12s %s\n",
+           "seq", "time [s]", "+[ms]", "pid", "event", "value", "app");
+
+    for (uint64_t i = first; i < header.next; i++)
+    {
+        const struct launch_event *event = &events[i % LAUNCH_EVENTS_CAPACITY];
+
+        // Being written or already overwritten while the snapshot was taken
+        if (event->sequence != i + 1)
+        {
+            incomplete++;
+            continue;
+        }
+
+        if (!previous)
+            previous = event->timestamp;
+
+        char app[LAUNCH_EVENTS_APP_LEN + 1];
+        memcpy(app, event->app, LAUNCH_EVENTS_APP_LEN);
+        app[LAUNCH_EVENTS_APP_LEN] = '\0';
+
+        char value[32];
+        format_value(event, value, sizeof(value));
+
+        printf("%10llu %14.6f %10.3f %7d %-17s %-12s %s\n",
+               (unsigned long long)i,
+               event->timestamp / 1e9,
+               (event->timestamp - previous) / 1e6,
+               event->pid,
+               event_name(event->type),
+               value,
+               app);
+
+        previous = event->timestamp;
+    }
+
+    if (incomplete)
+        printf("%u records were being written\n", incomplete);
+
+    return 0;
+}
@@ -29,6 +29,8 @@ AppData::AppData() :
     m_fileName(""),
     m_prio(0),
     m_delay(0),
+    m_cpuBoost(-1),
+    m_cpuBoostDuration(0),
     m_entry(NULL),
     m_ioDescriptors(),
     m_gid(0),
@@ -125,6 +127,22 @@ int AppData::delay() const
     return m_delay;
 }
 
+void AppData::setCpuBoost(int percent, int durationMs)
+{
+    m_cpuBoost = percent;
+    m_cpuBoostDuration = durationMs;
+}
+
+int AppData::cpuBoost() const
+{
+    return m_cpuBoost;
+}
+
+int AppData::cpuBoostDuration() const
+{
+    return m_cpuBoostDuration;
+}
+
 void AppData::setEntry(entry_t newEntry)
 {
     m_entry = newEntry;
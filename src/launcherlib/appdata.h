@@ -99,6 +99,15 @@ public:
     //!Return respawn delay
     int delay() const;
 
+    //! Set launch-time uclamp.min in percent, -1 if not requested, and its duration
+    void setCpuBoost(int percent, int durationMs);
+
+    //! Return launch-time uclamp.min in percent, -1 if not requested
+    int cpuBoost() const;
+
+    //! Return the duration of the CPU boost in milliseconds
+    int cpuBoostDuration() const;
+
     //! Set entry point for the application
     void setEntry(entry_t entry);
 
@@ -132,6 +141,8 @@ private:
     string      m_fileName;
     int         m_prio;
     int         m_delay;
+    int         m_cpuBoost;
+    int         m_cpuBoostDuration;
     entry_t     m_entry;
     vector<int> m_ioDescriptors;
     gid_t       m_gid;
@@ -23,8 +23,13 @@
 #include "singleinstance.h"
 #include "socketmanager.h"
 #include "logger.h"
+#include "eventlog.h"
+#include "probes.h"
+#include "preloader.h"
+#include "cpupolicy.h"
 
 #include <cstdlib>
+#include <malloc.h>
 #include <dlfcn.h>
 #include <cerrno>
 #include <unistd.h>
@@ -74,9 +79,33 @@ void Booster::initialize(int initialArgc, char ** initialArgv, int newBoosterLau
     // Drop priority (nice = 10)
     pushPriority(10);
 
+    Preloader preloader(boosterType());
+
+    // Scheduling of the booster, undone for the application
+    CpuPolicy cpuPolicy;
+
     // Preload stuff
     if (!m_bootMode)
+    {
+        LAUNCHER_PROBE1(preload_begin, boosterType().c_str());
+
+        // Tier 0 of the preload configuration of the type goes first
+        if (preloader.readConfig())
+        {
+            if (preloader.efficiencyCores())
+                cpuPolicy.useEfficiencyCores();
+
+            preloader.preload();
+        }
+
         preload();
+        LAUNCHER_PROBE1(preload_end, boosterType().c_str());
+    }
+
+    // The booster may wait for a long time, give back what preloading left over
+    if (!preloader.upgradable())
+        preloader.release();
+    trimMemory();
 
     // Rename process to temporary booster process name
     std::string temporaryProcessName = "booster [";
@@ -88,54 +117,98 @@ void Booster::initialize(int initialArgc, char ** initialArgv, int newBoosterLau
     // Restore priority
     popPriority();
 
+    EventLog::record(launch_event_respawn_finished, getpid(), 0, boosterType().c_str());
+    LAUNCHER_PROBE1(respawn_end, getpid());
+
+    // The higher preload tiers are loaded while no invoker is waiting
+    if (preloader.upgradable())
+    {
+        // SCHED_IDLE only if the booster can switch back for the application
+        const bool idle = preloader.idleUpgrade() && cpuPolicy.enterIdle();
+        if (!idle)
+            pushPriority(10);
+
+        if (preloader.upgrade(socketFd))
+        {
+            preloader.release();
+            trimMemory();
+        }
+
+        if (idle)
+            cpuPolicy.leaveIdle();
+        else
+            popPriority();
+    }
+
     while (true)
     {
         // Wait and read commands from the invoker
-        Logger::logDebug("Booster: Wait for message from invoker");
+        LOGGER_DEBUG("Booster: Wait for message from invoker");
         if (!receiveDataFromInvoker(socketFd))
             throw std::runtime_error("Booster: Couldn't read command\n");
 
         // Run process as single instance if requested
         if (m_appData->singleInstance())
         {
-            // Check if instance is already running
-            SingleInstancePluginEntry * pluginEntry = singleInstance->pluginEntry();
-            if (pluginEntry)
+            // Check from the launcher if instance is already running
+            const pid_t instancePid = lockSingleInstance();
+            if (instancePid > 0)
             {
-                if (!pluginEntry->lockFunc(m_appData->appName().c_str()))
+                // Try to activate the window of the existing instance
+                SingleInstancePluginEntry * pluginEntry = singleInstance->pluginEntry();
+                if (!pluginEntry)
+                {
+                    LOGGER_WARNING("Booster: Single-instance plugin not loaded, can't activate existing instance!");
+                    m_connection->sendExitValue(EXIT_FAILURE);
+                }
+                else if (!pluginEntry->activateExistingInstanceFunc(m_appData->appName().c_str()))
                 {
-                    // Try to activate the window of the existing instance
-                    if (!pluginEntry->activateExistingInstanceFunc(m_appData->appName().c_str()))
-                    {
-                        Logger::logWarning("Booster: Can't activate existing instance of the application!");
-                        m_connection->sendExitValue(EXIT_FAILURE);
-                    }
-                    else
-                    {
-                        m_connection->sendExitValue(EXIT_SUCCESS);
-                    }
-                    m_connection->close();
-
-                    // invoker requested to start an application that is already running
-                    // booster is not needed this time, let's wait for the next connection from invoker
-                    continue;
+                    LOGGER_WARNING("Booster: Can't activate existing instance of the application!");
+                    m_connection->sendExitValue(EXIT_FAILURE);
                 }
+                else
+                {
+                    m_connection->sendExitValue(EXIT_SUCCESS);
+                }
+                m_connection->close();
 
-                // Close the single-instance plugin
-                singleInstance->closePlugin();
+                // invoker requested to start an application that is already running
+                // booster is not needed this time, let's wait for the next connection from invoker
+                sendIdleToParent();
+                continue;
             }
-            else
+            else if (instancePid < 0)
             {
-                Logger::logWarning("Booster: Single-instance launch wanted, but single-instance plugin not loaded!");
+                LOGGER_WARNING("Booster: Single-instance launch wanted, but launcher didn't answer!");
             }
+
+            // Close the single-instance plugin
+            singleInstance->closePlugin();
         }
 
         //this instance of booster will be used to start application, exit from the loop
         break;
     }
 
+    // The application may use all CPUs again
+    cpuPolicy.restoreAffinity();
+
+    // Without a boost in the request the configuration of the application applies
+    if (m_appData->cpuBoost() < 0)
+    {
+        int percent, durationMs;
+        if (CpuPolicy::configuredBoost(m_appData->fileName(), percent, durationMs))
+            m_appData->setCpuBoost(percent, durationMs);
+    }
+
+    // Boost before telling the parent, which resets the boost after its duration
+    if (m_appData->cpuBoost() > 0 && m_appData->cpuBoostDuration() > 0 &&
+        !CpuPolicy::boost(m_appData->cpuBoost()))
+        m_appData->setCpuBoost(0, 0);
+
     // Send parent process a message that it can create a new booster,
-    // send pid of invoker, booster respawn value and invoker socket connection.
+    // send pid of invoker, booster respawn value, CPU boost and invoker
+    // socket connection.
     sendDataToParent();
 
     // Give the process the real application name now that it
@@ -151,16 +224,61 @@ void Booster::initialize(int initialArgc, char ** initialArgv, int newBoosterLau
     prctl(PR_SET_PDEATHSIG, 0);
 }
 
+// Sum Rss and Pss, in kB, over all mappings in an smaps file
+static void readFootprint(const char * path, int & rss, int & pss)
+{
+    rss = pss = -1;
+
+    FILE * smaps = fopen(path, "re");
+    if (!smaps)
+        return;
+
+    rss = pss = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), smaps))
+    {
+        if (strncmp(line, "Rss:", 4) == 0)
+            rss += atoi(line + 4);
+        else if (strncmp(line, "Pss:", 4) == 0)
+            pss += atoi(line + 4);
+    }
+
+    fclose(smaps);
+}
+
+void Booster::trimMemory()
+{
+    // Free heap pages, also the ones between allocated chunks,
+    // are returned to the kernel with MADV_DONTNEED
+    malloc_trim(0);
+
+    // smaps_rollup has the sums precomputed, older kernels only smaps
+    const char * path = access("/proc/self/smaps_rollup", R_OK) == 0 ?
+        "/proc/self/smaps_rollup" : "/proc/self/smaps";
+
+    int rss, pss;
+    readFootprint(path, rss, pss);
+    LOGGER_DEBUG("Booster: idle footprint of %s: RSS %d kB, PSS %d kB", boosterType().c_str(), rss, pss);
+
+    EventLog::record(launch_event_booster_rss, getpid(), rss, boosterType().c_str());
+    EventLog::record(launch_event_booster_pss, getpid(), pss, boosterType().c_str());
+}
+
 bool Booster::bootMode() const
 {
     return m_bootMode;
 }
 
+int Booster::respawnDelay() const
+{
+    return 2;
+}
+
 void Booster::sendDataToParent()
 {
     // Number of data items to be sent to
     // the parent (launcher) process
-    const unsigned int NUM_DATA_ITEMS = 2;
+    const unsigned int NUM_DATA_ITEMS = 4;
 
     struct iovec    iov[NUM_DATA_ITEMS];
     struct msghdr   msg;
@@ -169,15 +287,24 @@ void Booster::sendDataToParent()
 
     // Signal the parent process that it can create a new
     // waiting booster process and close write end
+    int type = BOOSTER_MSG_LAUNCHED;
+    iov[0].iov_base = &type;
+    iov[0].iov_len  = sizeof(int);
+
     // Send to the parent process pid of invoker for tracking
     pid_t pid = invokersPid();
-    iov[0].iov_base = &pid;
-    iov[0].iov_len  = sizeof(pid_t);
+    iov[1].iov_base = &pid;
+    iov[1].iov_len  = sizeof(pid_t);
 
     // Send to the parent process booster respawn delay value
     int delay = m_appData->delay();
-    iov[1].iov_base = &delay;
-    iov[1].iov_len  = sizeof(int);
+    iov[2].iov_base = &delay;
+    iov[2].iov_len  = sizeof(int);
+
+    // Send to the parent process the CPU boost to reset after its duration
+    int boost[2] = {m_appData->cpuBoost(), m_appData->cpuBoostDuration()};
+    iov[3].iov_base = boost;
+    iov[3].iov_len  = sizeof(boost);
 
     msg.msg_iov     = iov;
     msg.msg_iovlen  = NUM_DATA_ITEMS;
@@ -209,7 +336,80 @@ void Booster::sendDataToParent()
 
     if (sendmsg(boosterLauncherSocket(), &msg, 0) < 0)
     {
-        Logger::logError("Booster: Couldn't send data to launcher process\n");
+        LOGGER_ERROR("Booster: Couldn't send data to launcher process\n");
+    }
+}
+
+void Booster::sendIdleToParent()
+{
+    int type = BOOSTER_MSG_IDLE;
+    if (send(boosterLauncherSocket(), &type, sizeof(type), 0) < 0)
+    {
+        LOGGER_ERROR("Booster: Couldn't send data to launcher process\n");
+    }
+}
+
+void Booster::sendRegisterToParent()
+{
+    struct
+    {
+        int   type;
+        pid_t pid;
+        int   version;
+    } msg = {BOOSTER_MSG_REGISTER, getpid(), BOOSTER_ABI_VERSION};
+
+    if (send(boosterLauncherSocket(), &msg, sizeof(msg), 0) < 0)
+    {
+        LOGGER_ERROR("Booster: Couldn't send data to launcher process\n");
+    }
+}
+
+pid_t Booster::lockSingleInstance()
+{
+    const string & name = m_appData->appName();
+
+    int type  = BOOSTER_MSG_LOCK;
+    pid_t pid = getpid();
+    int delay = 0;
+
+    struct iovec iov[4];
+    iov[0].iov_base = &type;
+    iov[0].iov_len  = sizeof(int);
+    iov[1].iov_base = &pid;
+    iov[1].iov_len  = sizeof(pid_t);
+    iov[2].iov_base = &delay;
+    iov[2].iov_len  = sizeof(int);
+    iov[3].iov_base = const_cast<char *>(name.c_str());
+    iov[3].iov_len  = name.size();
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = 4;
+
+    if (sendmsg(boosterLauncherSocket(), &msg, 0) < 0)
+    {
+        LOGGER_ERROR("Booster: Couldn't send data to launcher process\n");
+        return -1;
+    }
+
+    // The launcher answers with the pid of the asking booster and the pid
+    // of the running instance. Skip answers meant for earlier boosters.
+    pid_t reply[2] = {0, 0};
+    while (true)
+    {
+        ssize_t ret = recv(boosterLauncherSocket(), reply, sizeof(reply), 0);
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret != sizeof(reply))
+        {
+            LOGGER_ERROR("Booster: Couldn't read data from launcher process\n");
+            return -1;
+        }
+
+        if (reply[0] == pid)
+            return reply[1];
     }
 }
 
@@ -226,8 +426,13 @@ bool Booster::receiveDataFromInvoker(int socketFd)
     // Setup the conversation channel with the invoker.
     m_connection = new Connection(socketFd);
 
-    // Accept a new invocation.
-    if (m_connection->accept(m_appData))
+    // Accept a new invocation. A re-executed daemon asks the booster
+    // to register before it hands any connections over.
+    bool accepted;
+    while (!(accepted = m_connection->accept(m_appData)) && m_connection->registerRequested())
+        sendRegisterToParent();
+
+    if (accepted)
     {
         // Receive application data from the invoker
         if(!m_connection->receiveApplicationData(m_appData))
@@ -261,11 +466,11 @@ int Booster::run(SocketManager * socketManager)
         }
 
         // Execute the binary
-        Logger::logDebug("Booster: invoking '%s' ", m_appData->fileName().c_str());
+        LOGGER_DEBUG("Booster: invoking '%s' ", m_appData->fileName().c_str());
         try {
             return launchProcess();
         } catch (const std::runtime_error &e) {
-            Logger::logError("Booster: Failed to invoke: %s\n", e.what());
+            LOGGER_ERROR("Booster: Failed to invoke: %s\n", e.what());
             // Also log to the terminal so the error appears on the terminal too
             fprintf(stderr, "Failed to invoke: %s\n", e.what());
             return EXIT_FAILURE;
@@ -273,7 +478,7 @@ int Booster::run(SocketManager * socketManager)
     }
     else
     {
-        Logger::logError("Booster: nothing to invoke\n");
+        LOGGER_ERROR("Booster: nothing to invoke\n");
         return EXIT_FAILURE;
     }
 }
@@ -319,7 +524,7 @@ void Booster::renameProcess(int parentArgc, char** parentArgv,
 
         // Set the process name using prctl, 'killall' and 'top' use it
         if ( prctl(PR_SET_NAME, basename(sourceArgv[0])) == -1 )
-            Logger::logError("Booster: on set new process name: %s ", strerror(errno));
+            LOGGER_ERROR("Booster: on set new process name: %s ", strerror(errno));
 
         setenv("_", sourceArgv[0], true);
     }
@@ -420,7 +625,7 @@ void Booster::setEnvironmentBeforeLaunch()
     const char * pwd = getenv("PWD");
     if (pwd) chdir(pwd);
 
-    Logger::logDebug("Booster: launching process: '%s' ", m_appData->fileName().c_str());
+    LOGGER_DEBUG("Booster: launching process: '%s' ", m_appData->fileName().c_str());
 }
 
 int Booster::launchProcess()
@@ -438,8 +643,13 @@ int Booster::launchProcess()
     __gcov_flush();
 #endif
 
-    // Close syslog
-    closelog();
+    EventLog::record(launch_event_main_entered, getpid(), 0, m_appData->fileName().c_str());
+    LAUNCHER_PROBE1(main_entry, m_appData->fileName().c_str());
+
+    // Write out pending messages and close the log so that
+    // the application doesn't inherit any log descriptors
+    Logger::closeLog();
+    EventLog::close();
 
     // Jump to main()
     const int retVal = m_appData->entry()(m_appData->argc(), const_cast<char **>(m_appData->argv()));
@@ -468,7 +678,9 @@ void* Booster::loadMain()
 #endif
 
     // Load the application as a library
+    LAUNCHER_PROBE1(dlopen_begin, m_appData->fileName().c_str());
     void * module = dlopen(m_appData->fileName().c_str(), dlopenFlags);
+    LAUNCHER_PROBE1(dlopen_end, m_appData->fileName().c_str());
 
     if (!module)
         throw std::runtime_error(std::string("Booster: Loading invoked application failed: '") +
@@ -563,15 +775,15 @@ void Booster::resetOomAdj()
     {
         if (write(fd, "0", sizeof(char)) == -1)
         {
-            Logger::logError("Couldn't write to '%s': %s", PROC_OOM_ADJ_FILE,
-                             strerror(errno));
+            LOGGER_ERROR("Couldn't write to '%s': %s", PROC_OOM_ADJ_FILE,
+                         strerror(errno));
         }
 
         close(fd);
     }
     else
     {
-        Logger::logError("Couldn't open '%s' for write: %s", PROC_OOM_ADJ_FILE,
-                         strerror(errno));
+        LOGGER_ERROR("Couldn't open '%s' for write: %s", PROC_OOM_ADJ_FILE,
+                     strerror(errno));
     }
 }
@@ -33,6 +33,32 @@ class Connection;
 class SocketManager;
 class SingleInstance;
 
+//! Types of the messages boosters send to the daemon
+enum BoosterMessageType
+{
+    //! The booster took an invoker connection into use, a new booster is needed
+    BOOSTER_MSG_LAUNCHED = 1,
+
+    //! The booster served a connection without launching, it can take a new one
+    BOOSTER_MSG_IDLE     = 2,
+
+    //! The booster wants to run the application given by name as a single instance
+    BOOSTER_MSG_LOCK     = 3,
+
+    //! The booster answers the registration request of a re-executed daemon
+    BOOSTER_MSG_REGISTER = 4
+};
+
+/*!
+ * Version of the interface between the daemon and the boosters it forks:
+ * the booster messages, the connection handoff, the single-instance lock
+ * and the launch event journal. A booster kept warm over a daemon re-exec
+ * is used only if its version matches the new daemon, and booster plugins
+ * are loaded only if they were built against the same version. Increase
+ * this when any of them or the Booster class changes incompatibly.
+ */
+const int BOOSTER_ABI_VERSION = 2;
+
 /*!
  *  \class Booster
  *  \brief Abstract base class for all boosters (Qt-booster, M-booster and so on..)
@@ -61,7 +87,7 @@ public:
      * \param initialArgc argc of the parent process.
      * \param initialArgv argv of the parent process.
      * \param boosterLauncherSocket socket connection to the parent process.
-     * \param socketFd socket used to get commands from the invoker.
+     * \param socketFd socket the parent process hands invoker connections over.
      * \param singleInstance Pointer to a valid SingleInstance object.
      * \param bootMode Booster-specific preloads are not executed if true.
      */
@@ -107,6 +133,13 @@ public:
      */
     virtual const string & boosterType() const = 0;
 
+    /*!
+     * \brief Return the respawn delay in seconds.
+     * The daemon waits this long before replacing a booster that died
+     * without launching anything. Re-implement to change the default.
+     */
+    virtual int respawnDelay() const;
+
     //! Get invoker's pid
     pid_t invokersPid();
 
@@ -145,10 +178,10 @@ protected:
 
     /*!
      * \brief Wait for connection from invoker and read the input.
-     * This method accepts a socket connection from the invoker
-     * and reads the data of an application to be launched.
+     * This method takes an invoker connection handed over by the
+     * parent process and reads the data of an application to be launched.
      *
-     * \param socketFd Fd of the UNIX socket file.
+     * \param socketFd Fd of the socket connections are handed over.
      * \return true on success
      */
     virtual bool receiveDataFromInvoker(int socketFd);
@@ -191,9 +224,25 @@ private:
     //! and signal that a new booster can be created.
     void sendDataToParent();
 
+    //! Signal the parent process that this booster can take a new connection.
+    void sendIdleToParent();
+
+    //! Register with a re-executed parent process, telling BOOSTER_ABI_VERSION.
+    void sendRegisterToParent();
+
+    /*! \brief Ask the parent process to register this booster as the single
+     *  instance of the application being launched.
+     *  \return pid of the running instance, 0 if this booster got registered,
+     *  or -1 on failure.
+     */
+    pid_t lockSingleInstance();
+
     //! Helper method: load the library and find out address for "main".
     void* loadMain();
 
+    //! Release memory left over from preloading and record the idle footprint
+    void trimMemory();
+
     //! Socket connection to invoker
     Connection* m_connection;
 
@@ -218,4 +267,22 @@ private:
 #endif
 };
 
+//! Name of the factory function exported by booster plugins
+#define BOOSTER_PLUGIN_FACTORY "createBooster"
+
+//! Name of the BOOSTER_ABI_VERSION the booster plugin was built with
+#define BOOSTER_PLUGIN_ABI_VERSION "boosterAbiVersion"
+
+//! Signature of the factory function of booster plugins
+typedef Booster * (*BoosterFactory)();
+
+/*!
+ * Export the factory of booster class TYPE from a booster plugin. Plugins
+ * installed in BOOSTER_PLUGIN_DIR are hosted by the daemon next to its
+ * own booster, see Daemon::loadBoosterPlugins().
+ */
+#define BOOSTER_PLUGIN(TYPE) \
+    extern "C" DECL_EXPORT const int boosterAbiVersion = BOOSTER_ABI_VERSION; \
+    extern "C" DECL_EXPORT Booster * createBooster() { return new TYPE; }
+
 #endif // BOOSTER_H
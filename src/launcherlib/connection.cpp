@@ -19,6 +19,7 @@
 
 #include "connection.h"
 #include "logger.h"
+#include "probes.h"
 
 #include <sys/socket.h>
 #include <sys/un.h>       /* for getsockopt */
@@ -27,19 +28,58 @@
 #include <cstdlib>
 #include <cerrno>
 #include <unistd.h>
+#include <algorithm>
 #include <stdexcept>
 #include <sys/syslog.h>
 
+// Payload of the messages of a launch request following the application name
+static const struct
+{
+    uint32_t action;
+    Connection::PayloadKind kind;
+    uint32_t words;
+} PAYLOADS[] =
+{
+    { INVOKER_MSG_EXEC,      Connection::StringPayload,  0 },
+    { INVOKER_MSG_ARGS,      Connection::StringsPayload, 0 },
+    { INVOKER_MSG_ENV,       Connection::StringsPayload, 0 },
+    { INVOKER_MSG_PRIO,      Connection::WordsPayload,   1 },
+    { INVOKER_MSG_DELAY,     Connection::WordsPayload,   1 },
+    { INVOKER_MSG_IDS,       Connection::WordsPayload,   2 },
+    { INVOKER_MSG_CPU_BOOST, Connection::WordsPayload,   2 },
+    { INVOKER_MSG_IO,        Connection::IOPayload,      0 },
+    { INVOKER_MSG_END,       Connection::EndPayload,     0 }
+};
+
+Connection::PayloadKind Connection::payloadKind(uint32_t action, uint32_t & words)
+{
+    for (unsigned int i = 0; i < sizeof(PAYLOADS) / sizeof(PAYLOADS[0]); i++)
+    {
+        if (PAYLOADS[i].action == action)
+        {
+            words = PAYLOADS[i].words;
+            return PAYLOADS[i].kind;
+        }
+    }
+
+    words = 0;
+    return InvalidPayload;
+}
+
 Connection::Connection(int socketFd, bool testMode) :
         m_testMode(testMode),
         m_fd(-1),
         m_curSocket(socketFd),
+        m_registerRequested(false),
         m_fileName(""),
         m_argc(0),
         m_argv(NULL),
         m_priority(0),
         m_delay(0),
+        m_cpuBoost(-1),
+        m_cpuBoostDuration(0),
         m_sendPid(false),
+        m_sendAck(true),
         m_gid(0),
         m_uid(0)
 {
@@ -75,18 +115,60 @@ bool Connection::accept(AppData* appData)
 {
     if (!m_testMode)
     {
-        m_fd = ::accept(m_curSocket, NULL, NULL);
+        // A dummy byte followed by the header the daemon has already read, if any
+        char data[1 + HEADER_SIZE_MAX];
+
+        struct iovec iov;
+        iov.iov_base = data;
+        iov.iov_len  = sizeof(data);
+
+        char buf[CMSG_SPACE(sizeof(int))];
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = buf;
+        msg.msg_controllen = sizeof(buf);
 
-        if (m_fd < 0)
+        ssize_t ret = recvmsg(m_curSocket, &msg, 0);
+        if (ret < 0)
         {
-            Logger::logError("Connection: Failed to accept a connection: %s\n", strerror(errno));
+            LOGGER_ERROR("Connection: Failed to accept a connection: %s\n", strerror(errno));
             return false;
         }
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        m_registerRequested = cmsg == NULL && ret == 1 && data[0] == REGISTER_REQUEST;
+        if (m_registerRequested)
+        {
+            LOGGER_DEBUG("Connection: registration requested");
+            return false;
+        }
+
+        if (cmsg == NULL || cmsg->cmsg_len != CMSG_LEN(sizeof(int)) ||
+            cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            LOGGER_ERROR("Connection: Failed to accept a connection: no descriptor received\n");
+            return false;
+        }
+
+        memcpy(&m_fd, CMSG_DATA(cmsg), sizeof(int));
+
+        if (ret > 1)
+            m_header.assign(data + 1, ret - 1);
+        else
+            m_header.clear();
     }
 
     return true;
 }
 
+bool Connection::registerRequested() const
+{
+    return m_registerRequested;
+}
+
 bool Connection::connected() const
 {
     return m_fd > -1;
@@ -109,7 +191,7 @@ bool Connection::sendMsg(uint32_t msg)
 {
     if (!m_testMode)
     {
-        Logger::logDebug("Connection: %s: %08x", __FUNCTION__, msg);
+        LOGGER_DEBUG("Connection: %s: %08x", __FUNCTION__, msg);
         return write(m_fd, &msg, sizeof(msg)) != -1;
     }
     else
@@ -118,23 +200,45 @@ bool Connection::sendMsg(uint32_t msg)
     }
 }
 
+ssize_t Connection::recvData(void * buf, size_t size)
+{
+    size_t done = 0;
+    if (!m_header.empty())
+    {
+        done = std::min(size, m_header.size());
+        memcpy(buf, m_header.data(), done);
+        m_header.erase(0, done);
+    }
+
+    if (done < size)
+    {
+        ssize_t ret = read(m_fd, static_cast<char *>(buf) + done, size - done);
+        if (ret < 0)
+            return done ? static_cast<ssize_t>(done) : -1;
+
+        done += ret;
+    }
+
+    return done;
+}
+
 bool Connection::recvMsg(uint32_t *msg)
 {
     if (!m_testMode)
     {
         uint32_t buf = 0;
         int len = sizeof(buf);
-        ssize_t ret = read(m_fd, &buf, len);
+        ssize_t ret = recvData(&buf, len);
 
         if (ret < len)
         {
-            Logger::logError("Connection: can't read data from connecton in %s", __FUNCTION__);
+            LOGGER_ERROR("Connection: can't read data from connecton in %s", __FUNCTION__);
             *msg = 0;
         }
         else
         {
-            Logger::logDebug("Connection: %s: %08x", __FUNCTION__, *msg);
             *msg = buf;
+            LOGGER_TRACE("Connection: %s: %08x", __FUNCTION__, *msg);
         }
 
         return ret != -1;
@@ -152,32 +256,31 @@ const char * Connection::recvStr()
         // Get the size.
         uint32_t size = 0;
 
-        const uint32_t STR_LEN_MAX = 4096;
         bool res = recvMsg(&size);
-        if (!res || size == 0 || size > STR_LEN_MAX)
+        if (!res || size == 0 || size > INVOKER_STR_LEN_MAX)
         {
-            Logger::logError("Connection: string receiving failed in %s, string length is %d", __FUNCTION__, size);
+            LOGGER_ERROR("Connection: string receiving failed in %s, string length is %d", __FUNCTION__, size);
             return NULL;
         }
 
         char * str = new char[size];
         if (!str)
         {
-            Logger::logError("Connection: mallocing in %s", __FUNCTION__);
+            LOGGER_ERROR("Connection: mallocing in %s", __FUNCTION__);
             return NULL;
         }
 
         // Get the string.
-        uint32_t ret = read(m_fd, str, size);
-        if (ret < size)
+        ssize_t ret = recvData(str, size);
+        if (ret < static_cast<ssize_t>(size))
         {
-            Logger::logError("Connection: getting string, got %u of %u bytes", ret, size);
+            LOGGER_ERROR("Connection: getting string, got %d of %u bytes", static_cast<int>(ret), size);
             delete [] str;
             return NULL;
         }
 
         str[size - 1] = '\0';
-        Logger::logDebug("Connection: %s: '%s'", __FUNCTION__, str);
+        LOGGER_TRACE("Connection: %s: '%s'", __FUNCTION__, str);
 
         return str;
     }
@@ -214,11 +317,12 @@ uint32_t Connection::receiveMagic()
     {
         if (!((magic & INVOKER_MSG_MAGIC_VERSION_MASK) == INVOKER_MSG_MAGIC_VERSION))
         {
-            Logger::logError("Connection: receiving bad magic version (%08x)\n", magic);
+            LOGGER_ERROR("Connection: receiving bad magic version (%08x)\n", magic);
             return -1;
         }
     }
     m_sendPid  = magic & INVOKER_MSG_MAGIC_OPTION_WAIT;
+    m_sendAck  = !(magic & INVOKER_MSG_MAGIC_OPTION_NO_ACK);
 
     return magic & INVOKER_MSG_MAGIC_OPTION_MASK;
 }
@@ -231,14 +335,14 @@ string Connection::receiveAppName()
     recvMsg(&msg);
     if (msg != INVOKER_MSG_NAME)
     {
-        Logger::logError("Connection: receiving invalid action (%08x)", msg);
+        LOGGER_ERROR("Connection: receiving invalid action (%08x)", msg);
         return string();
     }
 
     const char* name = recvStr();
     if (!name)
     {
-        Logger::logError("Connection: receiving application name");
+        LOGGER_ERROR("Connection: receiving application name");
         return string();
     }
 
@@ -270,6 +374,17 @@ bool Connection::receiveDelay()
     return true;
 }
 
+bool Connection::receiveCpuBoost()
+{
+    uint32_t percent, duration;
+    recvMsg(&percent);
+    recvMsg(&duration);
+
+    m_cpuBoost = std::min(percent, static_cast<uint32_t>(100));
+    m_cpuBoostDuration = std::min(duration, INVOKER_CPU_BOOST_MAX_MS);
+    return true;
+}
+
 bool Connection::receiveIDs()
 {
     recvMsg(&m_uid);
@@ -281,14 +396,13 @@ bool Connection::receiveArgs()
 {
     // Get argc
     recvMsg(&m_argc);
-    const uint32_t ARG_MAX = 1024;
-    if (m_argc > 0 && m_argc < ARG_MAX)
+    if (m_argc > 0 && m_argc <= INVOKER_ARGS_MAX)
     {
         // Reserve memory for argv
         m_argv = new const char * [m_argc];
         if (!m_argv)
         {
-            Logger::logError("Connection: reserving memory for argv");
+            LOGGER_ERROR("Connection: reserving memory for argv");
             return false;
         }
 
@@ -298,14 +412,14 @@ bool Connection::receiveArgs()
             m_argv[i] = recvStr();
             if (!m_argv[i])
             {
-                Logger::logError("Connection: receiving argv[%i]", i);
+                LOGGER_ERROR("Connection: receiving argv[%i]", i);
                 return false;
             }
         }
     }
     else
     {
-        Logger::logError("Connection: invalid number of parameters %d", m_argc);
+        LOGGER_ERROR("Connection: invalid number of parameters %d", m_argc);
         return false;
     }
 
@@ -326,14 +440,11 @@ int putenv_wrapper(char * var)
 
 bool Connection::receiveEnv()
 {
-    // Have some "reasonable" limit for environment variables to protect from
-    // malicious data
-    const uint32_t MAX_VARS = 1024;
-
-    // Get number of environment variables.
+    // Get number of environment variables. INVOKER_ENV_MAX is a "reasonable"
+    // limit to protect from malicious data.
     uint32_t n_vars = 0;
     recvMsg(&n_vars);
-    if (n_vars > 0 && n_vars < MAX_VARS)
+    if (n_vars > 0 && n_vars <= INVOKER_ENV_MAX)
     {
         // Get environment variables
         for (uint32_t i = 0; i < n_vars; i++)
@@ -341,7 +452,7 @@ bool Connection::receiveEnv()
             const char * var = recvStr();
             if (var == NULL)
             {
-                Logger::logError("Connection: receiving environ[%i]", i);
+                LOGGER_ERROR("Connection: receiving environ[%i]", i);
                 return false;
             }
 
@@ -353,20 +464,20 @@ bool Connection::receiveEnv()
             {
                 if (putenv_wrapper(const_cast<char *>(var)) != 0)
                 {
-                    Logger::logWarning("Connection: putenv failed");
+                    LOGGER_WARNING("Connection: putenv failed");
                 }
             }
             else
             {
                 delete [] var;
                 var = NULL;
-                Logger::logWarning("Connection: invalid environment data");
+                LOGGER_WARNING("Connection: invalid environment data");
             }
         }
     }
     else
     {
-        Logger::logError("Connection: invalid environment variable count %d", n_vars);
+        LOGGER_ERROR("Connection: invalid environment variable count %d", n_vars);
         return false;
     }
 
@@ -400,13 +511,13 @@ bool Connection::receiveIO()
 
     if (recvmsg(m_fd, &msg, 0) < 0)
     {
-        Logger::logWarning("Connection: recvmsg failed in invoked_get_io: %s", strerror(errno));
+        LOGGER_WARNING("Connection: recvmsg failed in invoked_get_io: %s", strerror(errno));
         return false;
     }
 
     if (msg.msg_flags)
     {
-        Logger::logWarning("Connection: unexpected msg flags in invoked_get_io");
+        LOGGER_WARNING("Connection: unexpected msg flags in invoked_get_io");
         return false;
     }
 
@@ -414,7 +525,7 @@ bool Connection::receiveIO()
     if (cmsg == NULL || cmsg->cmsg_len != CMSG_LEN(sizeof(m_io)) ||
         cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
     {
-        Logger::logWarning("Connection: invalid cmsg in invoked_get_io");
+        LOGGER_WARNING("Connection: invalid cmsg in invoked_get_io");
         return false;
     }
 
@@ -425,7 +536,7 @@ bool Connection::receiveIO()
 
 bool Connection::receiveActions()
 {
-    Logger::logDebug("Connection: enter: %s", __FUNCTION__);
+    LOGGER_DEBUG("Connection: enter: %s", __FUNCTION__);
 
     while (1)
     {
@@ -433,6 +544,7 @@ bool Connection::receiveActions()
 
         // Get the action.
         recvMsg(&action);
+        LAUNCHER_PROBE1(message, action);
 
         switch (action)
         {
@@ -458,6 +570,10 @@ bool Connection::receiveActions()
             receiveDelay();
             break;
 
+        case INVOKER_MSG_CPU_BOOST:
+            receiveCpuBoost();
+            break;
+
         case INVOKER_MSG_IO:
             receiveIO();
             break;
@@ -467,15 +583,18 @@ bool Connection::receiveActions()
             break;
 
         case INVOKER_MSG_SPLASH:
-            Logger::logError("Connection: received a now-unsupported MSG_SPLASH\n");
+            LOGGER_ERROR("Connection: received a now-unsupported MSG_SPLASH\n");
             return false;
 
         case INVOKER_MSG_LANDSCAPE_SPLASH:
-            Logger::logError("Connection: received a now-unsupported MSG_LANDSCAPE_SPLASH\n");
+            LOGGER_ERROR("Connection: received a now-unsupported MSG_LANDSCAPE_SPLASH\n");
             return false;
 
         case INVOKER_MSG_END:
-            sendMsg(INVOKER_MSG_ACK);
+            // A fire-and-forget invoker has already gone away, so errors
+            // from here on can only be reported to the log.
+            if (m_sendAck)
+                sendMsg(INVOKER_MSG_ACK);
 
             if (m_sendPid)
                 sendPid(getpid());
@@ -483,9 +602,24 @@ bool Connection::receiveActions()
             return true;
 
         default:
-            Logger::logError("Connection: received invalid action (%08x)\n", action);
+        {
+            // Fixed size messages this booster doesn't act on are skipped
+            uint32_t words = 0;
+            if (payloadKind(action, words) == WordsPayload)
+            {
+                LOGGER_DEBUG("Connection: ignoring action (%08x)", action);
+                for (uint32_t i = 0; i < words; i++)
+                {
+                    uint32_t value = 0;
+                    recvMsg(&value);
+                }
+                break;
+            }
+
+            LOGGER_ERROR("Connection: received invalid action (%08x)\n", action);
             return false;
         }
+        }
     }
 }
 
@@ -495,7 +629,7 @@ bool Connection::receiveApplicationData(AppData* appData)
     appData->setOptions(receiveMagic());
     if (appData->options() == -1)
     {
-        Logger::logError("Connection: receiving magic failed\n");
+        LOGGER_ERROR("Connection: receiving magic failed\n");
         return false;
     }
 
@@ -503,7 +637,7 @@ bool Connection::receiveApplicationData(AppData* appData)
     appData->setAppName(receiveAppName());
     if (appData->appName().empty())
     {
-        Logger::logError("Connection: receiving application name failed\n");
+        LOGGER_ERROR("Connection: receiving application name failed\n");
         return false;
     }
 
@@ -513,6 +647,7 @@ bool Connection::receiveApplicationData(AppData* appData)
         appData->setFileName(m_fileName);
         appData->setPriority(m_priority);
         appData->setDelay(m_delay);
+        appData->setCpuBoost(m_cpuBoost, m_cpuBoostDuration);
         appData->setArgc(m_argc);
         appData->setArgv(m_argv);
         appData->setIODescriptors(vector<int>(m_io, m_io + IO_DESCRIPTOR_COUNT));
@@ -520,7 +655,8 @@ bool Connection::receiveApplicationData(AppData* appData)
     }
     else
     {
-        Logger::logError("Connection: receiving application parameters failed\n");
+        LOGGER_ERROR("Connection: receiving application parameters for '%s' failed\n",
+                     appData->appName().c_str());
         return false;
     }
 
@@ -539,7 +675,7 @@ pid_t Connection::peerPid()
     socklen_t len = sizeof(struct ucred);
     if (getsockopt(m_fd, SOL_SOCKET, SO_PEERCRED, &cr, &len) < 0)
     {
-        Logger::logError("Connection: can't get peer's pid: %s\n", strerror(errno));
+        LOGGER_ERROR("Connection: can't get peer's pid: %s\n", strerror(errno));
         return 0;
     }
     return cr.pid;
@@ -43,8 +43,33 @@ class DECL_EXPORT Connection
 {
 public:
 
+    //! Maximum size of the request header (magic and application name)
+    //! the daemon may have read before handing a connection over
+    static const unsigned int HEADER_SIZE_MAX = 3 * sizeof(uint32_t) + INVOKER_STR_LEN_MAX;
+
+    //! Sent instead of a connection by a re-executed daemon that wants
+    //! the booster to register with it
+    static const char REGISTER_REQUEST = 'R';
+
+    //! Kind of the payload that follows a message of a launch request
+    enum PayloadKind
+    {
+        InvalidPayload, //!< Not a message of a launch request
+        WordsPayload,   //!< A fixed number of words
+        StringPayload,  //!< The size of a string and the string
+        StringsPayload, //!< A count of strings and the strings
+        IOPayload,      //!< Descriptors passed along with a single byte
+        EndPayload      //!< Nothing, the request ends
+    };
+
+    /*! \brief Return the kind of payload that follows action in a launch request.
+     *  The daemon skips requests with the same table that the booster parses them with.
+     *  \param words Set to the number of words of a WordsPayload.
+     */
+    static PayloadKind payloadKind(uint32_t action, uint32_t & words);
+
     /*! \brief Constructor.
-     *  \param socketFd Fd of the UNIX file socket to be used.
+     *  \param socketFd Fd of the socket invoker connections are handed over.
      *  \param testMode Bypass all real socket activity to help unit testing.
      */
     explicit Connection(int socketFd, bool testMode = false);
@@ -54,7 +79,9 @@ public:
 
 
     /*! \brief Accept connection.
-     * Accept a socket connection from the invoker.
+     * Take an invoker connection the daemon has accepted and
+     * handed over through the socket given to the constructor,
+     * along with the beginning of the request if the daemon read it.
      * Stores security credentials of the connected
      * peer to appData, if security is enabled. The credentials
      * in appData must be released by the caller.
@@ -62,6 +89,9 @@ public:
      */
     bool accept(AppData* appData);
 
+    //! \brief Return true if accept() got a registration request instead of a connection
+    bool registerRequested() const;
+
     //! \brief Close the socket connection.
     void close();
 
@@ -129,9 +159,15 @@ private:
     //! Receive booster respawn delay
     bool receiveDelay();
 
+    //! Receive launch-time CPU boost
+    bool receiveCpuBoost();
+
     //! Send process pid
     bool sendPid(pid_t pid);
 
+    //! Read size bytes, starting with the header read by the daemon
+    ssize_t recvData(void * buf, size_t size);
+
     //! Send message to a socket. This is a virtual to help unit testing.
     virtual bool sendMsg(uint32_t msg);
 
@@ -147,16 +183,25 @@ private:
     //! Fd of an accepted connection
     int m_fd;
 
-    //! Fd of the UNIX socket file
+    //! Fd of the socket invoker connections are handed over
     int m_curSocket;
 
+    //! True if the last accept() got a registration request
+    bool m_registerRequested;
+
+    //! Unconsumed part of the request header read by the daemon
+    string m_header;
+
     string   m_fileName;
     uint32_t m_argc;
     const char **  m_argv;
     int      m_io[IO_DESCRIPTOR_COUNT];
     uint32_t m_priority;
     uint32_t m_delay;
+    int      m_cpuBoost;
+    int      m_cpuBoostDuration;
     bool     m_sendPid;
+    bool     m_sendAck;
     gid_t    m_gid;
     uid_t    m_uid;
 
@@ -0,0 +1,334 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "cpupolicy.h"
+#include "logger.h"
+#include "protocol.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <fstream>
+#include <sstream>
+
+#define BOOSTER_CPU_BOOST_LIST "/usr/share/mapplauncherd/cpu-boost"
+
+#ifndef SCHED_FLAG_KEEP_POLICY
+#define SCHED_FLAG_KEEP_POLICY   0x08
+#endif
+#ifndef SCHED_FLAG_KEEP_PARAMS
+#define SCHED_FLAG_KEEP_PARAMS   0x10
+#endif
+#ifndef SCHED_FLAG_UTIL_CLAMP_MIN
+#define SCHED_FLAG_UTIL_CLAMP_MIN 0x20
+#endif
+
+// Utilization of the fastest core at its highest frequency
+static const int UCLAMP_SCALE = 1024;
+
+// Capability that allows leaving SCHED_IDLE
+static const int CAP_SYS_NICE_BIT = 23;
+
+// Argument of sched_setattr(2) and sched_getattr(2), which have no wrappers in older C libraries
+struct SchedAttr
+{
+    uint32_t size;
+    uint32_t policy;
+    uint64_t flags;
+    int32_t  nice;
+    uint32_t priority;
+    uint64_t runtime;
+    uint64_t deadline;
+    uint64_t period;
+    uint32_t utilMin;
+    uint32_t utilMax;
+};
+
+// Set uclamp.min of thread tid, keeping its policy and parameters
+static bool setUtilMin(pid_t tid, uint32_t utilMin)
+{
+    SchedAttr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size    = sizeof(attr);
+    attr.flags   = SCHED_FLAG_KEEP_POLICY | SCHED_FLAG_KEEP_PARAMS | SCHED_FLAG_UTIL_CLAMP_MIN;
+    attr.utilMin = utilMin;
+
+    return syscall(SYS_sched_setattr, tid, &attr, 0) == 0;
+}
+
+static uint32_t toUtil(int percent)
+{
+    return percent * UCLAMP_SCALE / 100;
+}
+
+// Read a CPU list like "0-3,8" from path
+static bool readCpuList(const char * path, cpu_set_t & cpus)
+{
+    CPU_ZERO(&cpus);
+
+    FILE * file = fopen(path, "re");
+    if (!file)
+        return false;
+
+    char list[256];
+    const bool ok = fgets(list, sizeof(list), file) != NULL;
+    fclose(file);
+    if (!ok)
+        return false;
+
+    char * savePtr = NULL;
+    for (char * range = strtok_r(list, ",\n", &savePtr); range; range = strtok_r(NULL, ",\n", &savePtr))
+    {
+        int first, last;
+        const int count = sscanf(range, "%d-%d", &first, &last);
+        if (count < 1)
+            return false;
+        if (count == 1)
+            last = first;
+
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &cpus);
+    }
+
+    return true;
+}
+
+// Find the efficiency cores among the allowed CPUs
+static bool efficiencyCores(const cpu_set_t & allowed, cpu_set_t & cores)
+{
+    CPU_ZERO(&cores);
+
+    // Arm big.LITTLE and DynamIQ: the cores with less than the highest capacity
+    static int capacity[CPU_SETSIZE];
+    int maxCapacity = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        capacity[cpu] = 0;
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+        FILE * file = fopen(path, "re");
+        if (file)
+        {
+            if (fscanf(file, "%d", &capacity[cpu]) != 1)
+                capacity[cpu] = 0;
+            fclose(file);
+        }
+
+        if (capacity[cpu] > maxCapacity)
+            maxCapacity = capacity[cpu];
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (capacity[cpu] > 0 && capacity[cpu] < maxCapacity)
+            CPU_SET(cpu, &cores);
+    }
+
+    // Intel hybrid CPUs list their Atom cores separately
+    cpu_set_t atoms;
+    if (CPU_COUNT(&cores) == 0 && readCpuList("/sys/devices/cpu_atom/cpus", atoms))
+        CPU_AND(&cores, &atoms, const_cast<cpu_set_t *>(&allowed));
+
+    // Nothing to gain if the process is restricted to them anyway
+    return CPU_COUNT(&cores) > 0 && !CPU_EQUAL(&cores, &allowed);
+}
+
+// Return true if the calling thread may switch from SCHED_IDLE back to its nice value
+static bool mayLeaveIdle()
+{
+    unsigned long long capabilities = 0;
+    FILE * status = fopen("/proc/self/status", "re");
+    if (status)
+    {
+        char line[128];
+        while (fgets(line, sizeof(line), status))
+        {
+            if (sscanf(line, "CapEff: %llx", &capabilities) == 1)
+                break;
+        }
+        fclose(status);
+    }
+
+    if (capabilities & (1ULL << CAP_SYS_NICE_BIT))
+        return true;
+
+    errno = 0;
+    const int nice = getpriority(PRIO_PROCESS, 0);
+    if (errno)
+        return false;
+
+    struct rlimit limit;
+    return getrlimit(RLIMIT_NICE, &limit) == 0 &&
+        (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= static_cast<rlim_t>(20 - nice));
+}
+
+CpuPolicy::CpuPolicy() :
+    m_pinned(false),
+    m_policy(-1)
+{
+    CPU_ZERO(&m_affinity);
+}
+
+CpuPolicy::~CpuPolicy()
+{
+    leaveIdle();
+    restoreAffinity();
+}
+
+bool CpuPolicy::useEfficiencyCores()
+{
+    if (m_pinned || sched_getaffinity(0, sizeof(m_affinity), &m_affinity) == -1)
+        return false;
+
+    cpu_set_t cores;
+    if (!efficiencyCores(m_affinity, cores))
+    {
+        LOGGER_DEBUG("CpuPolicy: no efficiency cores");
+        return false;
+    }
+
+    if (sched_setaffinity(0, sizeof(cores), &cores) == -1)
+    {
+        LOGGER_WARNING("CpuPolicy: can't move to efficiency cores: %s", strerror(errno));
+        return false;
+    }
+
+    LOGGER_DEBUG("CpuPolicy: running on %d efficiency cores", CPU_COUNT(&cores));
+    m_pinned = true;
+    return true;
+}
+
+void CpuPolicy::restoreAffinity()
+{
+    if (!m_pinned)
+        return;
+
+    if (sched_setaffinity(0, sizeof(m_affinity), &m_affinity) == -1)
+        LOGGER_WARNING("CpuPolicy: can't restore affinity: %s", strerror(errno));
+
+    m_pinned = false;
+}
+
+bool CpuPolicy::enterIdle()
+{
+    if (m_policy != -1)
+        return true;
+
+    if (!mayLeaveIdle())
+    {
+        LOGGER_DEBUG("CpuPolicy: SCHED_IDLE not used, it could not be left");
+        return false;
+    }
+
+    const int policy = sched_getscheduler(0);
+    struct sched_param param;
+    param.sched_priority = 0;
+    if (policy == -1 || sched_setscheduler(0, SCHED_IDLE, &param) == -1)
+    {
+        LOGGER_DEBUG("CpuPolicy: can't set SCHED_IDLE: %s", strerror(errno));
+        return false;
+    }
+
+    m_policy = policy;
+    return true;
+}
+
+void CpuPolicy::leaveIdle()
+{
+    if (m_policy == -1)
+        return;
+
+    struct sched_param param;
+    param.sched_priority = 0;
+    if (sched_setscheduler(0, m_policy, &param) == -1)
+        LOGGER_ERROR("CpuPolicy: can't leave SCHED_IDLE: %s", strerror(errno));
+
+    m_policy = -1;
+}
+
+bool CpuPolicy::boost(int percent)
+{
+    if (!setUtilMin(0, toUtil(percent)))
+    {
+        LOGGER_DEBUG("CpuPolicy: can't set uclamp.min: %s", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+void CpuPolicy::unboost(pid_t pid, int percent)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+    DIR * tasks = opendir(path);
+    if (!tasks)
+        return;
+
+    const uint32_t utilMin = toUtil(percent);
+    while (struct dirent * task = readdir(tasks))
+    {
+        const pid_t tid = atoi(task->d_name);
+        if (tid <= 0)
+            continue;
+
+        // Clamps the application has set itself stay
+        SchedAttr attr;
+        memset(&attr, 0, sizeof(attr));
+        if (syscall(SYS_sched_getattr, tid, &attr, sizeof(attr), 0) == 0 && attr.utilMin == utilMin)
+            setUtilMin(tid, 0);
+    }
+
+    closedir(tasks);
+}
+
+bool CpuPolicy::configuredBoost(const string & fileName, int & percent, int & durationMs)
+{
+    std::ifstream config(BOOSTER_CPU_BOOST_LIST);
+    string line;
+    while (std::getline(config, line))
+    {
+        std::istringstream fields(line);
+        string program;
+        if (!(fields >> program) || program[0] == '#' || program != fileName)
+            continue;
+
+        if (!(fields >> percent >> durationMs) || percent < 0 || percent > 100 ||
+            durationMs < 0 || durationMs > static_cast<int>(INVOKER_CPU_BOOST_MAX_MS))
+        {
+            LOGGER_WARNING("CpuPolicy: malformed boost of %s in %s", fileName.c_str(), BOOSTER_CPU_BOOST_LIST);
+            return false;
+        }
+
+        return true;
+    }
+
+    return false;
+}
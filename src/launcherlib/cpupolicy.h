@@ -0,0 +1,109 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef CPUPOLICY_H
+#define CPUPOLICY_H
+
+#include <sched.h>
+#include <sys/types.h>
+
+#include <string>
+
+using std::string;
+
+/*!
+ * \class CpuPolicy
+ * \brief CPU scheduling of boosters and the applications launched from them.
+ *
+ * A booster may run on the efficiency cores of a heterogeneous CPU while
+ * it preloads and waits, and preload its higher tiers with SCHED_IDLE.
+ * Both are undone before an application is launched. The application
+ * itself can get a temporary utilization clamp (uclamp.min) so that the
+ * scheduler runs it on a fast core at a high frequency while it starts.
+ *
+ * Launch boosts of applications are read from BOOSTER_CPU_BOOST_LIST:
+ *
+ * \code
+ * # program            uclamp.min %   milliseconds
+ * /usr/bin/myapp       80             300
+ * \endcode
+ */
+class CpuPolicy
+{
+public:
+
+    //! Constructor
+    CpuPolicy();
+
+    //! Destructor, restores the affinity and policy
+    ~CpuPolicy();
+
+    /*! \brief Restrict the calling process to the efficiency cores.
+     *  \return false if the CPU has no distinct efficiency cores.
+     */
+    bool useEfficiencyCores();
+
+    //! Restore the affinity changed by useEfficiencyCores()
+    void restoreAffinity();
+
+    /*! \brief Switch the calling thread to SCHED_IDLE. Not done unless the
+     *  thread may switch back, which needs CAP_SYS_NICE or RLIMIT_NICE.
+     *  \return false if the policy was not changed.
+     */
+    bool enterIdle();
+
+    //! Restore the policy changed by enterIdle()
+    void leaveIdle();
+
+    /*! \brief Set uclamp.min of the calling thread. Threads created
+     *  after this inherit it.
+     *  \param percent Minimum utilization in percent of the fastest core.
+     *  \return false if the kernel doesn't support utilization clamping.
+     */
+    static bool boost(int percent);
+
+    /*! \brief Reset uclamp.min of the threads of pid that still have the
+     *  value set by boost(), leaving other clamps in place.
+     */
+    static void unboost(pid_t pid, int percent);
+
+    /*! \brief Find the launch boost of an application in BOOSTER_CPU_BOOST_LIST.
+     *  \return false if the application is not listed.
+     */
+    static bool configuredBoost(const string & fileName, int & percent, int & durationMs);
+
+private:
+
+    //! Disable copy-constructor
+    CpuPolicy(const CpuPolicy & r);
+
+    //! Disable assignment operator
+    CpuPolicy & operator= (const CpuPolicy & r);
+
+    //! Affinity before useEfficiencyCores()
+    cpu_set_t m_affinity;
+
+    //! True if m_affinity is to be restored
+    bool m_pinned;
+
+    //! Policy before enterIdle(), -1 if not idle
+    int m_policy;
+};
+
+#endif // CPUPOLICY_H
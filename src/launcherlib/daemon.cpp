@@ -19,10 +19,19 @@
 
 #include "daemon.h"
 #include "logger.h"
+#include "eventlog.h"
+#include "probes.h"
 #include "connection.h"
 #include "booster.h"
 #include "singleinstance.h"
 #include "socketmanager.h"
+#include "launchbatch.h"
+#include "requestreader.h"
+#include "memorypressure.h"
+#include "sharingaudit.h"
+#include "cpupolicy.h"
+#include "savedstate.h"
+#include "protocol.h"
 
 #include <cstdlib>
 #include <cerrno>
@@ -47,7 +56,6 @@
 extern char ** environ;
 
 Daemon * Daemon::m_instance = NULL;
-const int Daemon::m_boosterSleepTime = 2;
 
 const std::string Daemon::m_stateDir = std::string(getenv("XDG_RUNTIME_DIR"))+"/applauncherd";
 const std::string Daemon::m_stateFile = Daemon::m_stateDir + "/saved-state";
@@ -88,20 +96,78 @@ static void sigHupHandler(int)
     write(Daemon::instance()->sigPipeFd(), &v, 1);
 }
 
+static void sigAuditHandler(int)
+{
+    char v = SIGRTMIN;
+    write(Daemon::instance()->sigPipeFd(), &v, 1);
+}
+
+// Return the pid of the process holding the lock file that the standalone
+// single-instance tool takes for name, 0 if the file isn't locked
+static pid_t singleInstanceLockHolder(const string & name)
+{
+    const char * runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (!runtimeDir || !*runtimeDir)
+        return 0;
+
+    const string path = string(runtimeDir) + "/single-instance-locks/" + name + "/instance.lock";
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return 0;
+
+    // The same region the plugin's lock() locks
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type   = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    fl.l_start  = 0;
+    fl.l_len    = 1;
+
+    pid_t holder = 0;
+    if (fcntl(fd, F_GETLK, &fl) == 0 && fl.l_type != F_UNLCK)
+        holder = fl.l_pid;
+
+    close(fd);
+    return holder;
+}
+
+// Seconds of CLOCK_MONOTONIC, used for booster idle times
+static time_t monotonicTime()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec;
+}
+
+// Milliseconds of CLOCK_MONOTONIC, used for CPU boosts
+static long long monotonicMillis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
 Daemon::Daemon(int & argc, char * argv[]) :
     m_daemon(false),
     m_debugMode(false),
     m_bootMode(false),
-    m_boosterPid(0),
+    m_connectionCount(0),
     m_socketManager(new SocketManager),
     m_singleInstance(new SingleInstance),
     m_reExec(false),
+    m_stateFd(-1),
     m_notifySystemd(false),
-    m_booster(0)
+    m_onDemand(false),
+    m_idleTimeout(0),
+    m_pressureStall(0),
+    m_memoryPressure(new MemoryPressure),
+    m_underPressure(false),
+    m_pressureChecked(0)
 {
     // Open the log
     Logger::openLog(argc > 0 ? argv[0] : "booster");
-    Logger::logDebug("starting..");
+    Logger::setBuffered(true);
+    LOGGER_DEBUG("starting..");
 
     // Install signal handlers. The original handlers are saved
     // in the daemon instance so that they can be restored in boosters.
@@ -111,6 +177,7 @@ Daemon::Daemon(int & argc, char * argv[]) :
     setUnixSignalHandler(SIGUSR2, sigUsr2Handler); // enter boot mode (same as --boot-mode)
     setUnixSignalHandler(SIGPIPE, sigPipeHandler); // broken invoker's pipe
     setUnixSignalHandler(SIGHUP,  sigHupHandler);  // re-exec
+    setUnixSignalHandler(SIGRTMIN, sigAuditHandler); // write memory sharing report
 
     if (!Daemon::m_instance)
     {
@@ -133,11 +200,6 @@ Daemon::Daemon(int & argc, char * argv[]) :
     m_initialArgv = argv;
     m_initialArgc = argc;
 
-    if (!m_reExec && socketpair(AF_UNIX, SOCK_DGRAM, 0, m_boosterLauncherSocket) == -1)
-    {
-        throw std::runtime_error("Daemon: Creating a socket pair for boosters failed!\n");
-    }
-
     if (!m_reExec && pipe(m_sigPipeFd) == -1)
     {
         throw std::runtime_error("Daemon: Creating a pipe for Unix signals failed!\n");
@@ -150,14 +212,162 @@ Daemon::Daemon(int & argc, char * argv[]) :
     }
 }
 
+Daemon::BoosterState::BoosterState() :
+    booster(0),
+    pid(0),
+    busy(false),
+    registering(false),
+    lastActive(0)
+{
+    launcherSocket[0] = launcherSocket[1] = -1;
+    connectionSocket[0] = connectionSocket[1] = -1;
+}
+
 Daemon * Daemon::instance()
 {
     return Daemon::m_instance;
 }
 
+void Daemon::addBooster(Booster *booster)
+{
+    const string type = booster->boosterType();
+
+    BoosterState & state = m_boosters[type];
+    if (state.booster)
+    {
+        throw std::runtime_error("Daemon: Booster type '" + type + "' is already hosted!\n");
+    }
+
+    // State saved by a daemon hosting a single booster type has no type
+    BoosterMap::iterator untyped = m_boosters.find("");
+    if (untyped != m_boosters.end() && state.launcherSocket[0] == -1)
+    {
+        state = untyped->second;
+        m_boosters.erase(untyped);
+    }
+
+    state.booster = booster;
+
+    if (state.launcherSocket[0] == -1 &&
+        socketpair(AF_UNIX, SOCK_DGRAM, 0, state.launcherSocket) == -1)
+    {
+        throw std::runtime_error("Daemon: Creating a socket pair for boosters failed!\n");
+    }
+
+    if (state.connectionSocket[0] == -1 &&
+        socketpair(AF_UNIX, SOCK_DGRAM, 0, state.connectionSocket) == -1)
+    {
+        throw std::runtime_error("Daemon: Creating a socket pair for invoker connections failed!\n");
+    }
+
+    LOGGER_DEBUG("Daemon: hosting booster type '%s'", type.c_str());
+}
+
+void Daemon::loadBoosterPlugins()
+{
+    glob_t plugins;
+    if (glob(BOOSTER_PLUGIN_DIR "/*.so", 0, NULL, &plugins) == 0)
+    {
+        for (size_t i = 0; i < plugins.gl_pathc; i++)
+            loadBoosterPlugin(plugins.gl_pathv[i]);
+    }
+
+    globfree(&plugins);
+}
+
+bool Daemon::loadBoosterPlugin(const string & path)
+{
+    void * handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        LOGGER_WARNING("Daemon: dlopening booster plugin failed: %s", dlerror());
+        return false;
+    }
+
+    // Plugins built against another version of the Booster class can't be used
+    const int * abiVersion = (const int *)dlsym(handle, BOOSTER_PLUGIN_ABI_VERSION);
+    BoosterFactory factory = (BoosterFactory)dlsym(handle, BOOSTER_PLUGIN_FACTORY);
+    if (!abiVersion || *abiVersion != BOOSTER_ABI_VERSION || !factory)
+    {
+        LOGGER_WARNING("Daemon: Invalid booster plugin: '%s'", path.c_str());
+        dlclose(handle);
+        return false;
+    }
+
+    Booster * booster = factory();
+    try
+    {
+        addBooster(booster);
+    }
+    catch (const std::runtime_error & e)
+    {
+        LOGGER_WARNING("Daemon: Skipped booster plugin '%s': %s", path.c_str(), e.what());
+        delete booster;
+        dlclose(handle);
+        return false;
+    }
+
+    LOGGER_DEBUG("Daemon: booster plugin '%s' loaded", path.c_str());
+    return true;
+}
+
+Daemon::BoosterState * Daemon::findBooster(pid_t pid)
+{
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+    {
+        if (pid && i->second.pid == pid)
+            return &i->second;
+    }
+
+    return NULL;
+}
+
+void Daemon::removeUnhostedBoosters()
+{
+    BoosterMap::iterator i = m_boosters.begin();
+    while (i != m_boosters.end())
+    {
+        BoosterState & state = i->second;
+        if (state.booster)
+        {
+            i++;
+            continue;
+        }
+
+        // The type was hosted before re-exec, but its plugin is gone
+        LOGGER_WARNING("Daemon: booster type '%s' is not hosted any more", i->first.c_str());
+        killProcess(state.pid, SIGTERM);
+
+        for (ConnectionQueue::iterator j = state.connectionQueue.begin();
+             j != state.connectionQueue.end(); j++)
+            close(j->fd);
+
+        for (int j = 0; j < 2; j++)
+        {
+            if (state.launcherSocket[j] != -1)
+                close(state.launcherSocket[j]);
+            if (state.connectionSocket[j] != -1)
+                close(state.connectionSocket[j]);
+        }
+
+        m_boosters.erase(i++);
+    }
+}
+
 void Daemon::run(Booster *booster)
 {
-    m_booster = booster;
+    addBooster(booster);
+    run();
+}
+
+void Daemon::run()
+{
+    if (m_boosters.empty())
+    {
+        throw std::runtime_error("Daemon: No boosters to host!\n");
+    }
+
+    removeUnhostedBoosters();
 
     // Make sure that LD_BIND_NOW does not prevent dynamic linker to
     // use lazy binding in later dlopen() calls.
@@ -166,26 +376,45 @@ void Daemon::run(Booster *booster)
     // dlopen single-instance
     loadSingleInstancePlugin();
 
+    // Map the launch event journal, it is shared with the boosters of all
+    // types and named after the first one
+    EventLog::open(m_socketManager->socketRootPath() + m_boosters.begin()->first +
+                   LAUNCH_EVENTS_SUFFIX);
+
     if (m_reExec)
     {
         // Reap dead booster processes and restart them
         // Note: this cannot be done before booster plugins have been loaded
         reapZombies();
     }
-    else
+
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
     {
-        // Create socket for the booster
-        Logger::logDebug("Daemon: initing socket: %s", booster->boosterType().c_str());
-        m_socketManager->initSocket(booster->boosterType());
+        BoosterState & state = i->second;
+
+        // Create socket for the booster unless it was kept over re-exec,
+        // in which case only its capabilities file is rewritten
+        LOGGER_DEBUG("Daemon: initing socket: %s", i->first.c_str());
+        m_socketManager->initSocket(i->first);
 
-        // Fork each booster for the first time
-        Logger::logDebug("Daemon: forking booster: %s", booster->boosterType().c_str());
-        forkBooster();
+        if (state.registering)
+        {
+            requestBoosterRegistration(state);
+        }
+        else if (!state.pid && !m_onDemand)
+        {
+            // Fork each booster for the first time
+            LOGGER_DEBUG("Daemon: forking booster: %s", i->first.c_str());
+            forkBooster(state);
+        }
     }
 
+    if (m_pressureStall > 0)
+        m_memoryPressure->watch(m_pressureStall);
+
     // Notify systemd that init is done
     if (m_notifySystemd) {
-        Logger::logDebug("Daemon: initialization done. Notify systemd\n");
+        LOGGER_DEBUG("Daemon: initialization done. Notify systemd\n");
         sd_notify(0, "READY=1");
     }
 
@@ -194,64 +423,166 @@ void Daemon::run(Booster *booster)
     {
         // Variables used by the select call
         fd_set rfds;
+        fd_set wfds;
+        fd_set efds;
         int ndfs = 0;
 
         // Init data for select
         FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        FD_ZERO(&efds);
 
-        FD_SET(m_boosterLauncherSocket[0], &rfds);
-        ndfs = std::max(ndfs, m_boosterLauncherSocket[0]);
+        // PSI triggers are reported as exceptional conditions
+        const int pressureFd = m_memoryPressure->fd();
+        if (pressureFd != -1)
+        {
+            FD_SET(pressureFd, &efds);
+            ndfs = std::max(ndfs, pressureFd);
+        }
 
         FD_SET(m_sigPipeFd[0], &rfds);
         ndfs = std::max(ndfs, m_sigPipeFd[0]);
 
-        // Wait for something appearing in the pipes.
-        if (select(ndfs + 1, &rfds, NULL, NULL, NULL) > 0)
+        for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
         {
-            Logger::logDebug("Daemon: select done.");
+            const int launcherFd = i->second.launcherSocket[0];
+            FD_SET(launcherFd, &rfds);
+            ndfs = std::max(ndfs, launcherFd);
 
-            // Check if a booster died
-            if (FD_ISSET(m_boosterLauncherSocket[0], &rfds))
+            // Accept new connections only while there is room in the queue
+            const int listenFd = m_socketManager->findSocket(i->first);
+            if (listenFd != -1 && pendingConnections(i->first, i->second) < MAX_QUEUED_CONNECTIONS)
             {
-                Logger::logDebug("Daemon: FD_ISSET(m_boosterLauncherSocket[0])");
-                readFromBoosterSocket(m_boosterLauncherSocket[0]);
+                FD_SET(listenFd, &rfds);
+                ndfs = std::max(ndfs, listenFd);
+            }
+        }
+
+        for (ReaderVect::iterator i = m_readers.begin(); i != m_readers.end(); i++)
+        {
+            FD_SET((*i)->fd(), &rfds);
+            ndfs = std::max(ndfs, (*i)->fd());
+        }
+
+        for (BatchVect::iterator i = m_batches.begin(); i != m_batches.end(); i++)
+            (*i)->addToFdSet(&rfds, &ndfs);
+
+        // Wait until pending single-instance activations can be sent
+        const int activationFd = m_singleInstance->pendingActivationFd();
+        if (activationFd != -1)
+        {
+            FD_SET(activationFd, &wfds);
+            ndfs = std::max(ndfs, activationFd);
+        }
+
+        // Write out what was logged during the previous round before going idle
+        Logger::flush();
+
+        // Wait for something appearing in the pipes or an idle booster to time out.
+        struct timeval timeout;
+        if (select(ndfs + 1, &rfds, &wfds, &efds, idleTimeout(&timeout)) > 0)
+        {
+            LOGGER_DEBUG("Daemon: select done.");
+
+            // Continue reading the requests of accepted connections. Invokers
+            // that stall are dropped once something else wakes the daemon up.
+            ReaderVect::iterator reader = m_readers.begin();
+            while (reader != m_readers.end())
+            {
+                bool done = false;
+                if (FD_ISSET((*reader)->fd(), &rfds))
+                {
+                    done = readRequest(**reader);
+                }
+                else if ((*reader)->expired())
+                {
+                    LOGGER_ERROR("Daemon: Invoker of connection %d timed out", (*reader)->id());
+                    done = true;
+                }
+
+                if (done)
+                {
+                    delete *reader;
+                    reader = m_readers.erase(reader);
+                }
+                else
+                {
+                    reader++;
+                }
+            }
+
+            if (pressureFd != -1 && FD_ISSET(pressureFd, &efds))
+            {
+                LOGGER_DEBUG("Daemon: FD_ISSET(pressureFd)");
+                evictBoosters();
+            }
+
+            if (activationFd != -1 && FD_ISSET(activationFd, &wfds))
+            {
+                LOGGER_DEBUG("Daemon: FD_ISSET(activationFd)");
+                m_singleInstance->flushActivations();
+            }
+
+            for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+            {
+                // Check if an invoker connected
+                const int listenFd = m_socketManager->findSocket(i->first);
+                if (listenFd != -1 && FD_ISSET(listenFd, &rfds))
+                {
+                    LOGGER_DEBUG("Daemon: FD_ISSET(listenFd) of %s", i->first.c_str());
+                    acceptConnection(i->second, listenFd);
+                }
+            }
+
+            // Relay PIDs of applications launched for batch requests
+            for (BatchVect::iterator i = m_batches.begin(); i != m_batches.end(); i++)
+                (*i)->handleFdSet(&rfds);
+
+            for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+            {
+                // Check if a booster died
+                if (FD_ISSET(i->second.launcherSocket[0], &rfds))
+                {
+                    LOGGER_DEBUG("Daemon: FD_ISSET(launcherSocket[0]) of %s", i->first.c_str());
+                    readFromBoosterSocket(i->second);
+                }
             }
 
             // Check if we got SIGCHLD, SIGTERM, SIGUSR1 or SIGUSR2
             if (FD_ISSET(m_sigPipeFd[0], &rfds))
             {
-                Logger::logDebug("Daemon: FD_ISSET(m_sigPipeFd[0])");
+                LOGGER_DEBUG("Daemon: FD_ISSET(m_sigPipeFd[0])");
                 char dataReceived;
                 read(m_sigPipeFd[0], &dataReceived, 1);
 
                 switch (dataReceived)
                 {
                 case SIGCHLD:
-                    Logger::logDebug("Daemon: SIGCHLD received.");
+                    LOGGER_DEBUG("Daemon: SIGCHLD received.");
                     reapZombies();
                     break;
 
                 case SIGTERM:
-                    Logger::logDebug("Daemon: SIGTERM received.");
+                    LOGGER_DEBUG("Daemon: SIGTERM received.");
                     exit(EXIT_SUCCESS);
                     break;
 
                 case SIGUSR1:
-                    Logger::logDebug("Daemon: SIGUSR1 received.");
+                    LOGGER_DEBUG("Daemon: SIGUSR1 received.");
                     enterNormalMode();
                     break;
 
                 case SIGUSR2:
-                    Logger::logDebug("Daemon: SIGUSR2 received.");
+                    LOGGER_DEBUG("Daemon: SIGUSR2 received.");
                     enterBootMode();
                     break;
 
                 case SIGPIPE:
-                    Logger::logDebug("Daemon: SIGPIPE received.");
+                    LOGGER_DEBUG("Daemon: SIGPIPE received.");
                     break;
 
                 case SIGHUP:
-                    Logger::logDebug("Daemon: SIGHUP received.");
+                    LOGGER_DEBUG("Daemon: SIGHUP received.");
                     reExec();
 
                     // not reached if re-exec successful
@@ -259,76 +590,447 @@ void Daemon::run(Booster *booster)
                     
 
                 default:
+                    // SIGRTMIN is not a constant
+                    if (dataReceived == SIGRTMIN)
+                    {
+                        LOGGER_DEBUG("Daemon: SIGRTMIN received.");
+                        writeSharingAudit();
+                    }
                     break;
                 }
             }
+
+            removeFinishedBatches();
+            dispatchConnections();
         }
+
+        stopIdleBoosters();
+        rewarmBoosters();
+        decayCpuBoosts();
     }
 }
 
-void Daemon::readFromBoosterSocket(int fd)
+void Daemon::readFromBoosterSocket(BoosterState & state)
 {
+    int type         = 0;
     pid_t invokerPid = 0;
     int delay        = 0;
     struct msghdr   msg;
     struct cmsghdr *cmsg;
-    struct iovec    iov[2];
+    struct iovec    iov[4];
+    const ssize_t headerSize = sizeof(int) + sizeof(pid_t) + sizeof(int);
     char buf[CMSG_SPACE(sizeof(int))];
+    char name[INVOKER_STR_LEN_MAX];
 
-    iov[0].iov_base = &invokerPid;
-    iov[0].iov_len  = sizeof(pid_t);
-    iov[1].iov_base = &delay;
-    iov[1].iov_len  = sizeof(int);
+    iov[0].iov_base = &type;
+    iov[0].iov_len  = sizeof(int);
+    iov[1].iov_base = &invokerPid;
+    iov[1].iov_len  = sizeof(pid_t);
+    iov[2].iov_base = &delay;
+    iov[2].iov_len  = sizeof(int);
+    iov[3].iov_base = name;
+    iov[3].iov_len  = sizeof(name);
 
     msg.msg_iov        = iov;
-    msg.msg_iovlen     = 2;
+    msg.msg_iovlen     = 4;
     msg.msg_name       = NULL;
     msg.msg_namelen    = 0;
     msg.msg_control    = buf;
     msg.msg_controllen = sizeof(buf);
 
-    if (recvmsg(fd, &msg, 0) >= 0)
+    ssize_t received = recvmsg(state.launcherSocket[0], &msg, 0);
+    if (received >= 0)
     {
-        Logger::logDebug("Daemon: invoker's pid: %d\n", invokerPid);
-        Logger::logDebug("Daemon: respawn delay: %d \n", delay);
+        if (type == BOOSTER_MSG_LOCK)
+        {
+            // The pid is the one of the booster itself, the name follows the header
+            if (received > headerSize)
+                lockSingleInstance(state, invokerPid, string(name, received - headerSize));
+
+            return;
+        }
+
+        if (type == BOOSTER_MSG_REGISTER)
+        {
+            // A booster kept over re-exec answers, the pid is the one of
+            // the booster itself and the ABI version is in place of the delay
+            if (state.registering && invokerPid == state.pid)
+            {
+                state.registering = false;
+                if (delay == BOOSTER_ABI_VERSION)
+                {
+                    LOGGER_DEBUG("Daemon: booster %d registered\n", invokerPid);
+                    state.busy = false;
+                    state.lastActive = monotonicTime();
+                }
+                else
+                {
+                    LOGGER_WARNING("Daemon: booster %d has ABI version %d instead of %d, replacing it",
+                                   invokerPid, delay, BOOSTER_ABI_VERSION);
+                    killProcess(state.pid, SIGTERM);
+                }
+            }
+
+            return;
+        }
+
+        if (type == BOOSTER_MSG_IDLE)
+        {
+            // The booster didn't launch anything, it can take the next connection
+            LOGGER_DEBUG("Daemon: booster is idle again\n");
+            state.busy = false;
+            return;
+        }
+
+        LOGGER_DEBUG("Daemon: invoker's pid: %d\n", invokerPid);
+        LOGGER_DEBUG("Daemon: respawn delay: %d \n", delay);
+
+        // The launched application has boosted itself, the boost follows the header
+        int boost[2];
+        if (received >= headerSize + static_cast<ssize_t>(sizeof(boost)) && state.pid)
+        {
+            memcpy(boost, name, sizeof(boost));
+            if (boost[0] > 0 && boost[1] > 0)
+            {
+                LOGGER_DEBUG("Daemon: CPU boost of %d: %d%% for %d ms", state.pid, boost[0], boost[1]);
+                CpuBoost cpuBoost = {state.pid, boost[0], monotonicMillis() + boost[1]};
+                m_cpuBoosts.push_back(cpuBoost);
+            }
+        }
         if (invokerPid != 0)
         {
             // Store booster - invoker pid pair
             // Store booster - invoker socket pair
-            if (m_boosterPid)
+            if (state.pid)
             {
                 cmsg = CMSG_FIRSTHDR(&msg);
                 int newFd;                 
                 memcpy(&newFd, CMSG_DATA(cmsg), sizeof(int));
-                Logger::logDebug("Daemon: socket file descriptor: %d\n", newFd);
-                m_boosterPidToInvokerPid[m_boosterPid] = invokerPid;
-                m_boosterPidToInvokerFd[m_boosterPid] = newFd;
+                LOGGER_DEBUG("Daemon: socket file descriptor: %d\n", newFd);
+                m_boosterPidToInvokerPid[state.pid] = invokerPid;
+                m_boosterPidToInvokerFd[state.pid] = newFd;
             }
         }
     }
     else
     {
-        Logger::logError("Daemon: Nothing read from the socket\n");
+        LOGGER_ERROR("Daemon: Nothing read from the socket\n");
         // Critical error communicating with booster. Exiting applauncherd.
         _exit(EXIT_FAILURE);
     }
 
+    // Under memory pressure the next connection forks a new booster
+    if (m_underPressure)
+    {
+        state.pid = 0;
+        return;
+    }
+
     // 2nd param guarantees some time for the just launched application
     // to start up before forking new booster. Not doing this would
     // slow down the start-up significantly on single core CPUs.
 
-    forkBooster(delay);
+    forkBooster(state, delay);
+}
+
+void Daemon::lockSingleInstance(BoosterState & state, pid_t boosterPid, const string & name)
+{
+    pid_t reply[2] = {boosterPid, 0};
+    pid_t holder = 0;
+
+    InstanceMap::iterator it = m_singleInstances.find(name);
+    if (it != m_singleInstances.end() && kill(it->second, 0) == 0)
+    {
+        LOGGER_DEBUG("Daemon: '%s' is already running as %d", name.c_str(), it->second);
+        reply[1] = it->second;
+    }
+    else if ((holder = singleInstanceLockHolder(name)) > 0)
+    {
+        // Started by the standalone tool, which isn't a child to be reaped
+        LOGGER_DEBUG("Daemon: '%s' is already running as %d, locked", name.c_str(), holder);
+        reply[1] = holder;
+    }
+    else
+    {
+        LOGGER_DEBUG("Daemon: '%s' will run as %d", name.c_str(), boosterPid);
+        m_singleInstances[name] = boosterPid;
+    }
+
+    if (send(state.launcherSocket[0], reply, sizeof(reply), 0) < 0)
+    {
+        LOGGER_ERROR("Daemon: Failed to answer booster %d: %s\n", boosterPid, strerror(errno));
+    }
+}
+
+void Daemon::releaseSingleInstance(pid_t pid)
+{
+    for (InstanceMap::iterator it = m_singleInstances.begin(); it != m_singleInstances.end(); it++)
+    {
+        if (it->second == pid)
+        {
+            LOGGER_DEBUG("Daemon: '%s' is not running any more", it->first.c_str());
+            m_singleInstances.erase(it);
+            break;
+        }
+    }
+}
+
+void Daemon::acceptConnection(BoosterState & state, int socketFd)
+{
+    int fd = accept4(socketFd, NULL, NULL, SOCK_NONBLOCK);
+    if (fd < 0)
+    {
+        LOGGER_ERROR("Daemon: Failed to accept a connection: %s\n", strerror(errno));
+        return;
+    }
+
+    const int id = ++m_connectionCount;
+    EventLog::record(launch_event_received, 0, id);
+    LAUNCHER_PROBE1(accept, id);
+
+    // The invoker sends the request right after connecting, so
+    // most of the time it can be read without a round in select()
+    RequestReader * reader = new RequestReader(fd, id, state.booster->boosterType());
+    if (readRequest(*reader))
+        delete reader;
+    else
+        m_readers.push_back(reader);
+}
+
+bool Daemon::readRequest(RequestReader & reader)
+{
+    const RequestReader::Status status = reader.read();
+    if (status == RequestReader::Reading)
+        return false;
+
+    if (status == RequestReader::Failed)
+        return true;
+
+    if (status == RequestReader::BodySkipped)
+    {
+        answerRunningInstance(reader);
+        return true;
+    }
+
+    BoosterMap::iterator it = m_boosters.find(reader.boosterType());
+    if (it == m_boosters.end())
+        return true;
+
+    BoosterState & state = it->second;
+    const uint32_t magic = reader.magic();
+    const bool background = (magic & INVOKER_MSG_MASK) == INVOKER_MSG_MAGIC &&
+                            (magic & INVOKER_MSG_MAGIC_OPTION_BACKGROUND);
+
+    if (status == RequestReader::BatchRead)
+    {
+        LaunchBatch * batch = reader.takeBatch();
+        deque<int> connections;
+        batch->start(connections);
+        m_batches.push_back(batch);
+
+        for (deque<int>::iterator i = connections.begin(); i != connections.end(); i++)
+        {
+            QueuedConnection connection;
+            connection.fd = *i;
+            connection.id = reader.id();
+            connection.background = background;
+            connection.batch = true;
+            queueConnection(state, connection);
+        }
+
+        return true;
+    }
+
+    if (!reader.appName().empty())
+    {
+        InstanceMap::iterator instance = m_singleInstances.find(reader.appName());
+        if (instance != m_singleInstances.end() && kill(instance->second, 0) == 0)
+        {
+            // The rest of the request isn't needed, but the invoker
+            // waits for the reply only after sending all of it
+            reader.skipBody(instance->second);
+            return readRequest(reader);
+        }
+    }
+
+    QueuedConnection connection;
+    connection.fd = reader.releaseFd();
+    connection.id = reader.id();
+    connection.header = reader.header();
+    connection.background = background;
+    connection.batch = false;
+
+    // Boosters read the rest of the request with blocking I/O
+    fcntl(connection.fd, F_SETFL, fcntl(connection.fd, F_GETFL) & ~O_NONBLOCK);
+
+    queueConnection(state, connection);
+    return true;
+}
+
+size_t Daemon::pendingConnections(const string & boosterType, const BoosterState & state) const
+{
+    size_t count = state.connectionQueue.size();
+    for (ReaderVect::const_iterator i = m_readers.begin(); i != m_readers.end(); i++)
+    {
+        if ((*i)->boosterType() == boosterType)
+            count++;
+    }
+
+    return count;
+}
+
+void Daemon::queueConnection(BoosterState & state, const QueuedConnection & connection)
+{
+    ConnectionQueue & queue = state.connectionQueue;
+
+    // Foreground launches go after the queued foreground ones
+    // but ahead of all background ones
+    ConnectionQueue::iterator position = queue.end();
+    if (!connection.background)
+    {
+        position = queue.begin();
+        while (position != queue.end() && !position->background)
+            position++;
+    }
+
+    queue.insert(position, connection);
+
+    EventLog::record(launch_event_queued, 0, queue.size(), state.booster->boosterType().c_str());
+    LAUNCHER_PROBE2(queued, connection.id, queue.size());
+}
+
+void Daemon::answerRunningInstance(RequestReader & reader)
+{
+    const string & name = reader.appName();
+    const uint32_t magic = reader.magic();
+
+    // The activation is sent asynchronously if the plugin supports it
+    const bool activated = m_singleInstance->activateExistingInstance(name);
+    if (!activated)
+    {
+        LOGGER_WARNING("Daemon: Can't activate existing instance of '%s'", name.c_str());
+    }
+
+    uint32_t reply[5];
+    unsigned int count = 0;
+
+    if (!(magic & INVOKER_MSG_MAGIC_OPTION_NO_ACK))
+        reply[count++] = INVOKER_MSG_ACK;
+
+    if (magic & INVOKER_MSG_MAGIC_OPTION_WAIT)
+    {
+        reply[count++] = INVOKER_MSG_PID;
+        reply[count++] = reader.instancePid();
+        reply[count++] = INVOKER_MSG_EXIT;
+        reply[count++] = activated ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // The reply fits in the socket buffer, the reader closes the connection
+    if (count > 0)
+        send(reader.fd(), reply, count * sizeof(uint32_t), MSG_NOSIGNAL);
+}
+
+void Daemon::dispatchConnections()
+{
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+        dispatchConnections(i->second);
+}
+
+void Daemon::dispatchConnections(BoosterState & state)
+{
+    ConnectionQueue & queue = state.connectionQueue;
+
+    // Boosters started on demand or stopped for being idle are
+    // forked when a connection arrives
+    if (!state.pid && !queue.empty())
+    {
+        LOGGER_DEBUG("Daemon: forking booster on demand: %s",
+                     state.booster->boosterType().c_str());
+        forkBooster(state);
+    }
+
+    while (state.pid && !state.busy && !queue.empty())
+    {
+        int fd = queue.front().fd;
+
+        // A dummy byte followed by the header read by the daemon, if any
+        string data(1, '\0');
+        data += queue.front().header;
+
+        struct iovec iov;
+        iov.iov_base = const_cast<char *>(data.data());
+        iov.iov_len  = data.size();
+
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = buf;
+        msg.msg_controllen = sizeof(buf);
+
+        struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+        if (sendmsg(state.connectionSocket[0], &msg, MSG_DONTWAIT) < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+
+            LOGGER_ERROR("Daemon: Failed to hand connection over to booster: %s\n",
+                         strerror(errno));
+        }
+        else
+        {
+            EventLog::record(launch_event_booster_chosen, state.pid, queue.front().id);
+            LAUNCHER_PROBE2(booster_chosen, state.pid, queue.front().id);
+            state.busy = true;
+            state.lastActive = monotonicTime();
+        }
+
+        queue.pop_front();
+        close(fd);
+    }
+}
+
+void Daemon::relayBatchExit(pid_t pid, int status)
+{
+    for (BatchVect::iterator i = m_batches.begin(); i != m_batches.end(); i++)
+    {
+        if ((*i)->childExited(pid, status))
+            break;
+    }
+}
+
+void Daemon::removeFinishedBatches()
+{
+    BatchVect::iterator i = m_batches.begin();
+    while (i != m_batches.end())
+    {
+        if ((*i)->finished())
+        {
+            delete *i;
+            i = m_batches.erase(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
 }
 
 void Daemon::killProcess(pid_t pid, int signal) const
 {
     if (pid > 0)
     {
-        Logger::logDebug("Daemon: Killing pid %d with %d", pid, signal);
+        LOGGER_DEBUG("Daemon: Killing pid %d with %d", pid, signal);
         if (kill(pid, signal) != 0)
         {
-            Logger::logError("Daemon: Failed to kill %d: %s\n",
-                             pid, strerror(errno));
+            LOGGER_ERROR("Daemon: Failed to kill %d: %s\n",
+                         pid, strerror(errno));
         }
     }
 }
@@ -338,31 +1040,37 @@ void Daemon::loadSingleInstancePlugin()
     void * handle = dlopen(SINGLE_INSTANCE_PATH, RTLD_NOW);
     if (!handle)
     {
-        Logger::logWarning("Daemon: dlopening single-instance failed: %s", dlerror());
+        LOGGER_WARNING("Daemon: dlopening single-instance failed: %s", dlerror());
     }
     else
     {
         if (m_singleInstance->validateAndRegisterPlugin(handle))
         {
-            Logger::logDebug("Daemon: single-instance plugin loaded.'");
+            LOGGER_DEBUG("Daemon: single-instance plugin loaded.'");
         }
         else
         {
-            Logger::logWarning("Daemon: Invalid single-instance plugin: '%s'",
-                               SINGLE_INSTANCE_PATH);
+            LOGGER_WARNING("Daemon: Invalid single-instance plugin: '%s'",
+                           SINGLE_INSTANCE_PATH);
         }
     }
 }
 
-void Daemon::forkBooster(int sleepTime)
+void Daemon::forkBooster(BoosterState & state, int sleepTime)
 {
-    if (!m_booster) {
+    if (!state.booster) {
         // Critical error unknown booster type. Exiting applauncherd.
         _exit(EXIT_FAILURE);
     }
 
     // Invalidate current booster pid
-    m_boosterPid = 0;
+    state.pid = 0;
+
+    // Don't let the new booster inherit pending log messages
+    Logger::flush();
+
+    EventLog::record(launch_event_respawn_started, 0, sleepTime);
+    LAUNCHER_PROBE1(respawn_begin, sleepTime);
 
     // Fork a new process
     pid_t newPid = fork();
@@ -375,11 +1083,44 @@ void Daemon::forkBooster(int sleepTime)
         // Restore used signal handlers
         restoreUnixSignalHandlers();
 
+        // Boosters have no event loop that would flush the log
+        Logger::setBuffered(false);
+
         // Will get this signal if applauncherd dies
         prctl(PR_SET_PDEATHSIG, SIGHUP);
 
-        // Close unused read end of the booster socket
-        close(m_boosterLauncherSocket[0]);
+        for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+        {
+            // Close unused read end of the booster socket
+            close(i->second.launcherSocket[0]);
+
+            // Close unused write end of the connection socket
+            close(i->second.connectionSocket[0]);
+
+            // Sockets of the other booster types aren't used at all
+            if (&i->second != &state)
+            {
+                close(i->second.launcherSocket[1]);
+                close(i->second.connectionSocket[1]);
+            }
+
+            // Close invoker connections that belong to the daemon
+            ConnectionQueue & queue = i->second.connectionQueue;
+            for (ConnectionQueue::iterator j = queue.begin(); j != queue.end(); j++)
+                close(j->fd);
+            queue.clear();
+        }
+
+        // The bus connection of the daemon is of no use in boosters
+        m_singleInstance->closeActivationFd();
+        m_memoryPressure->close();
+
+        for (BatchVect::iterator i = m_batches.begin(); i != m_batches.end(); i++)
+            (*i)->closeAll();
+
+        for (ReaderVect::iterator i = m_readers.begin(); i != m_readers.end(); i++)
+            delete *i;
+        m_readers.clear();
 
         // Close signal pipe
         close(m_sigPipeFd[0]);
@@ -397,26 +1138,30 @@ void Daemon::forkBooster(int sleepTime)
         }
         // Set session id
         if (setsid() < 0)
-            Logger::logError("Daemon: Couldn't set session id\n");
+            LOGGER_ERROR("Daemon: Couldn't set session id\n");
+
+        // Boosters forked under memory pressure don't preload, like in the boot mode
+        const bool bootMode = m_bootMode || m_underPressure;
 
         // Guarantee some time for the just launched application to
         // start up before initializing new booster if needed.
         // Not done if in the boot mode.
-        if (!m_bootMode && sleepTime)
+        if (!bootMode && sleepTime)
             sleep(sleepTime);
 
-        Logger::logDebug("Daemon: Running a new Booster of type '%s'", m_booster->boosterType().c_str());
+        Booster * booster = state.booster;
+        LOGGER_DEBUG("Daemon: Running a new Booster of type '%s'", booster->boosterType().c_str());
 
         // Initialize and wait for commands from invoker
-        m_booster->initialize(m_initialArgc, m_initialArgv, m_boosterLauncherSocket[1],
-                              m_socketManager->findSocket(m_booster->boosterType().c_str()),
-                              m_singleInstance, m_bootMode);
+        booster->initialize(m_initialArgc, m_initialArgv, state.launcherSocket[1],
+                            state.connectionSocket[1],
+                            m_singleInstance, bootMode);
 
         // Run the current Booster
-        int retval = m_booster->run(m_socketManager);
+        int retval = booster->run(m_socketManager);
 
         // Finish
-        delete m_booster;
+        delete booster;
 
         // _exit() instead of exit() to avoid situation when destructors
         // for static objects may be run incorrectly
@@ -424,12 +1169,18 @@ void Daemon::forkBooster(int sleepTime)
     }
     else /* Parent process */
     {
+        EventLog::record(launch_event_fork, newPid, sleepTime);
+
         // Store the pid so that we can reap it later
         m_children.push_back(newPid);
+        m_childTypes[newPid] = state.booster->boosterType();
 
-        // Set current process ID globally to the given booster type
+        // Set current process ID to the given booster type
         // so that we now which booster to restart when booster exits.
-        m_boosterPid = newPid;
+        state.pid = newPid;
+        state.busy = false;
+        state.registering = false;
+        state.lastActive = monotonicTime();
     }
 }
 
@@ -445,27 +1196,53 @@ void Daemon::reapZombies()
         if (pid)
         {
             // The pid had exited. Remove it from the pid vector.
+            m_childTypes.erase(*i);
             i = m_children.erase(i);
 
+            // The pid may be reused, forget its boost
+            for (CpuBoostVect::iterator boost = m_cpuBoosts.begin(); boost != m_cpuBoosts.end(); boost++)
+            {
+                if (boost->pid == pid)
+                {
+                    m_cpuBoosts.erase(boost);
+                    break;
+                }
+            }
+
+            if (pid > 0)
+                EventLog::record(launch_event_exit, pid, status);
+
+            releaseSingleInstance(pid);
+
             // Find out if the exited process has a mapping with an invoker process.
             // If this is the case, then kill the invoker process with the same signal
             // that killed the exited process.
             PidMap::iterator it = m_boosterPidToInvokerPid.find(pid);
             if (it != m_boosterPidToInvokerPid.end())
             {
-                Logger::logDebug("Daemon: Terminated process had a mapping to an invoker pid");
+                LOGGER_DEBUG("Daemon: Terminated process had a mapping to an invoker pid");
+
+                // Processes launched for a batch request have the daemon as their
+                // invoker. The batch relays their exit status instead.
+                const bool batchLaunch = (*it).second == getpid();
+                LAUNCHER_PROBE2(exit_relay, pid, status);
+                if (batchLaunch)
+                    relayBatchExit(pid, status);
 
                 if (WIFEXITED(status))
                 {
-                    Logger::logInfo("Boosted process (pid=%d) exited with status %d\n", pid, WEXITSTATUS(status));
-                    Logger::logDebug("Daemon: child exited by exit(x), _exit(x) or return x\n");
-                    Logger::logDebug("Daemon: x == %d\n", WEXITSTATUS(status));
+                    LOGGER_INFO("Boosted process (pid=%d) exited with status %d\n", pid, WEXITSTATUS(status));
+                    LOGGER_DEBUG("Daemon: child exited by exit(x), _exit(x) or return x\n");
+                    LOGGER_DEBUG("Daemon: x == %d\n", WEXITSTATUS(status));
                     FdMap::iterator fd = m_boosterPidToInvokerFd.find(pid);
                     if (fd != m_boosterPidToInvokerFd.end())
                     {
-                        write((*fd).second, &INVOKER_MSG_EXIT, sizeof(uint32_t));
-                        int exitStatus = WEXITSTATUS(status);
-                        write((*fd).second, &exitStatus, sizeof(int));
+                        if (!batchLaunch)
+                        {
+                            write((*fd).second, &INVOKER_MSG_EXIT, sizeof(uint32_t));
+                            int exitStatus = WEXITSTATUS(status);
+                            write((*fd).second, &exitStatus, sizeof(int));
+                        }
                         close((*fd).second);
                         m_boosterPidToInvokerFd.erase(fd);
                     }
@@ -475,9 +1252,9 @@ void Daemon::reapZombies()
                     int signal = WTERMSIG(status);
                     pid_t invokerPid = (*it).second;
 
-                    Logger::logInfo("Boosted process (pid=%d) was terminated due to signal %d\n", pid, signal);
-                    Logger::logDebug("Daemon: Booster (pid=%d) was terminated due to signal %d\n", pid, signal);
-                    Logger::logDebug("Daemon: Killing invoker process (pid=%d) by signal %d..\n", invokerPid, signal);
+                    LOGGER_INFO("Boosted process (pid=%d) was terminated due to signal %d\n", pid, signal);
+                    LOGGER_DEBUG("Daemon: Booster (pid=%d) was terminated due to signal %d\n", pid, signal);
+                    LOGGER_DEBUG("Daemon: Killing invoker process (pid=%d) by signal %d..\n", invokerPid, signal);
 
                     FdMap::iterator fd = m_boosterPidToInvokerFd.find(pid);
                     if (fd != m_boosterPidToInvokerFd.end())
@@ -486,7 +1263,8 @@ void Daemon::reapZombies()
                         m_boosterPidToInvokerFd.erase(fd);
                     }
 
-                    killProcess(invokerPid, signal);
+                    if (!batchLaunch)
+                        killProcess(invokerPid, signal);
                 }
 
                 // Remove a dead booster
@@ -494,9 +1272,14 @@ void Daemon::reapZombies()
             }
 
             // Check if pid belongs to a booster and restart the dead booster if needed
-            if (pid == m_boosterPid)
+            BoosterState * state = findBooster(pid);
+            if (state && m_underPressure)
             {
-                forkBooster(m_boosterSleepTime);
+                state->pid = 0;
+            }
+            else if (state)
+            {
+                forkBooster(*state, state->booster->respawnDelay());
             }
         }
         else
@@ -576,7 +1359,7 @@ void Daemon::parseArgs(const ArgVect & args)
     {
         if ((*i) == "--boot-mode" || (*i) == "-b")
         {
-            Logger::logInfo("Daemon: Boot mode set.");
+            LOGGER_INFO("Daemon: Boot mode set.");
             m_bootMode = true;
         }
         else if ((*i) == "--daemon" || (*i) == "-d")
@@ -596,10 +1379,26 @@ void Daemon::parseArgs(const ArgVect & args)
         {
             m_reExec = true;
         }
+        else if ((*i) == "--state-fd" && i + 1 != args.end())
+        {
+            m_stateFd = atoi((*++i).c_str());
+        }
         else if ((*i) == "--systemd")
         {
             m_notifySystemd = true;
         }
+        else if ((*i) == "--on-demand")
+        {
+            m_onDemand = true;
+        }
+        else if ((*i) == "--idle-timeout" && i + 1 != args.end())
+        {
+            m_idleTimeout = atoi((*++i).c_str());
+        }
+        else if ((*i) == "--memory-pressure" && i + 1 != args.end())
+        {
+            m_pressureStall = atoi((*++i).c_str());
+        }
         else
         {
             if ((*i).find_first_not_of(' ') != string::npos)
@@ -623,8 +1422,20 @@ void Daemon::usage(const char *name, int status)
            "                   to the launcher.\n"
            "  -d, --daemon     Run as %s a daemon.\n"
            "  --systemd        Notify systemd when initialization is done\n"
+           "  --on-demand      Fork the booster of a type only when the first\n"
+           "                   invoker connects to it.\n"
+           "  --idle-timeout SECS\n"
+           "                   Stop boosters that have not been used for SECS\n"
+           "                   seconds, a new one is forked on the next launch.\n"
+           "  --memory-pressure MS\n"
+           "                   Stop idle boosters when tasks stall on memory for\n"
+           "                   MS milliseconds within a second. Until the pressure\n"
+           "                   subsides, boosters are forked only for launches and\n"
+           "                   without preloading.\n"
            "  --debug          Enable debug messages and log everything also to stdout.\n"
-           "  -h, --help       Print this help.\n\n",
+           "  -h, --help       Print this help.\n\n"
+           "Send SIGRTMIN to the launcher to write a report of the memory boosted\n"
+           "applications share with it to $XDG_RUNTIME_DIR/mapplauncherd/sharing-audit.\n\n",
            name, name, name);
 
     exit(status);
@@ -644,11 +1455,11 @@ void Daemon::enterNormalMode()
         // Kill current boosters
         killBoosters();
 
-        Logger::logInfo("Daemon: Exited boot mode.");
+        LOGGER_INFO("Daemon: Exited boot mode.");
     }
     else
     {
-        Logger::logInfo("Daemon: Already in normal mode.");
+        LOGGER_INFO("Daemon: Already in normal mode.");
     }
 }
 
@@ -661,23 +1472,203 @@ void Daemon::enterBootMode()
         // Kill current boosters
         killBoosters();
 
-        Logger::logInfo("Daemon: Entered boot mode.");
+        LOGGER_INFO("Daemon: Entered boot mode.");
     }
     else
     {
-        Logger::logInfo("Daemon: Already in boot mode.");
+        LOGGER_INFO("Daemon: Already in boot mode.");
     }
 }
 
 void Daemon::killBoosters()
 {
-    if (m_boosterPid)
-        killProcess(m_boosterPid, SIGTERM);
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+    {
+        if (i->second.pid)
+            killProcess(i->second.pid, SIGTERM);
+    }
 
-    // NOTE!!: m_boosterPid must not be cleared
+    // NOTE!!: the booster pids must not be cleared
     // in order to automatically start new boosters.
 }
 
+void Daemon::requestBoosterRegistration(BoosterState & state)
+{
+    // The booster waits for connections on the connection socket
+    const char request = Connection::REGISTER_REQUEST;
+    if (send(state.connectionSocket[0], &request, sizeof(request), MSG_DONTWAIT) < 0)
+    {
+        LOGGER_WARNING("Daemon: Failed to ask booster %d to register: %s", state.pid, strerror(errno));
+        state.registering = false;
+        killProcess(state.pid, SIGTERM);
+    }
+}
+
+struct timeval * Daemon::idleTimeout(struct timeval * timeout) const
+{
+    bool idle = false;
+    time_t deadline = 0;
+
+    // Pressure is polled until it subsides, there is no trigger for that
+    if (m_underPressure)
+    {
+        deadline = m_pressureChecked + PRESSURE_CHECK_INTERVAL;
+        idle = true;
+    }
+
+    for (BoosterMap::const_iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+    {
+        const BoosterState & state = i->second;
+        if (m_idleTimeout > 0 && state.pid && !state.busy && !state.registering)
+        {
+            const time_t stop = state.lastActive + m_idleTimeout;
+            if (!idle || stop < deadline)
+                deadline = stop;
+            idle = true;
+        }
+    }
+
+    long long wait = idle ? std::max(deadline - monotonicTime(), static_cast<time_t>(0)) * 1000LL : -1;
+
+    // CPU boosts end with millisecond precision
+    if (!m_cpuBoosts.empty())
+    {
+        const long long now = monotonicMillis();
+        for (CpuBoostVect::const_iterator i = m_cpuBoosts.begin(); i != m_cpuBoosts.end(); i++)
+        {
+            const long long left = std::max(i->end - now, 0LL);
+            if (wait < 0 || left < wait)
+                wait = left;
+        }
+    }
+
+    if (wait < 0)
+        return NULL;
+
+    timeout->tv_sec  = wait / 1000;
+    timeout->tv_usec = wait % 1000 * 1000;
+    return timeout;
+}
+
+void Daemon::stopIdleBoosters()
+{
+    if (m_idleTimeout <= 0)
+        return;
+
+    const time_t now = monotonicTime();
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+    {
+        BoosterState & state = i->second;
+        const int idle = now - state.lastActive;
+        if (state.pid && !state.busy && !state.registering && state.connectionQueue.empty() &&
+            idle >= m_idleTimeout)
+        {
+            LOGGER_DEBUG("Daemon: booster '%s' idle for %d s, stopping it", i->first.c_str(), idle);
+            EventLog::record(launch_event_booster_stopped, state.pid, idle);
+            killProcess(state.pid, SIGTERM);
+
+            // Forgetting the pid keeps reapZombies() from replacing the
+            // booster, the next connection forks a new one
+            state.pid = 0;
+        }
+    }
+}
+
+void Daemon::evictBoosters()
+{
+    m_pressureChecked = monotonicTime();
+    if (m_underPressure)
+        return;
+
+    m_underPressure = true;
+
+    const double average = MemoryPressure::someAverage();
+    LOGGER_INFO("Daemon: memory pressure (some avg10=%.2f), evicting idle boosters", average);
+
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+    {
+        BoosterState & state = i->second;
+        if (state.pid && !state.busy && !state.registering && state.connectionQueue.empty())
+        {
+            EventLog::record(launch_event_booster_evicted, state.pid, average * 100, i->first.c_str());
+            killProcess(state.pid, SIGTERM);
+
+            // Like with idle boosters, the next connection forks a new one
+            state.pid = 0;
+        }
+    }
+}
+
+void Daemon::decayCpuBoosts(bool all)
+{
+    const long long now = monotonicMillis();
+    CpuBoostVect::iterator i = m_cpuBoosts.begin();
+    while (i != m_cpuBoosts.end())
+    {
+        if (all || i->end <= now)
+        {
+            LOGGER_DEBUG("Daemon: CPU boost of %d ended", i->pid);
+            CpuPolicy::unboost(i->pid, i->percent);
+            i = m_cpuBoosts.erase(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void Daemon::rewarmBoosters()
+{
+    const time_t now = monotonicTime();
+    if (!m_underPressure || now < m_pressureChecked + PRESSURE_CHECK_INTERVAL)
+        return;
+
+    m_pressureChecked = now;
+
+    // The trigger fires at m_pressureStall / 10 percent, rewarm at half of that
+    const double average = MemoryPressure::someAverage();
+    if (average < 0 || average >= m_pressureStall / 20.0)
+        return;
+
+    m_underPressure = false;
+    LOGGER_INFO("Daemon: memory pressure subsided (some avg10=%.2f), rewarming boosters", average);
+
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+    {
+        BoosterState & state = i->second;
+        EventLog::record(launch_event_booster_rewarmed, state.pid, average * 100, i->first.c_str());
+
+        if (state.pid && !state.busy && !state.registering)
+        {
+            // Forked without preloading under pressure, reapZombies() replaces it
+            killProcess(state.pid, SIGTERM);
+        }
+        else if (!state.pid && !m_onDemand)
+        {
+            forkBooster(state);
+        }
+    }
+}
+
+void Daemon::writeSharingAudit()
+{
+    SharingAudit audit;
+    audit.addProcess(getpid(), SharingAudit::ROLE_DAEMON, "");
+
+    // Children that are not current boosters have been launched as applications
+    for (PidVect::const_iterator i = m_children.begin(); i != m_children.end(); i++)
+    {
+        TypeMap::const_iterator type = m_childTypes.find(*i);
+        audit.addProcess(*i, findBooster(*i) ? SharingAudit::ROLE_BOOSTER : SharingAudit::ROLE_APPLICATION,
+                         type != m_childTypes.end() ? type->second : "");
+    }
+
+    const string path = m_socketManager->socketRootPath() + "sharing-audit";
+    if (audit.write(path))
+        LOGGER_INFO("Daemon: memory sharing report written to %s", path.c_str());
+}
+
 void Daemon::setUnixSignalHandler(int signum, sighandler_t handler)
 {
     sighandler_t old_handler = signal(signum, handler);
@@ -713,103 +1704,160 @@ void Daemon::restoreUnixSignalHandlers()
 
 Daemon::~Daemon()
 {
+    for (ReaderVect::iterator i = m_readers.begin(); i != m_readers.end(); i++)
+        delete *i;
+
+    for (BatchVect::iterator i = m_batches.begin(); i != m_batches.end(); i++)
+        delete *i;
+
+    for (BoosterMap::iterator i = m_boosters.begin(); i != m_boosters.end(); i++)
+        delete i->second.booster;
+
     delete m_socketManager;
     delete m_singleInstance;
+    delete m_memoryPressure;
 
+    EventLog::close();
     Logger::closeLog();
 }
 
 void Daemon::reExec()
 {
-    Logger::logInfo("Daemon: Re-exec requested.");
+    LOGGER_INFO("Daemon: Re-exec requested.");
 
-    struct stat st;
-    if (stat(m_stateDir.c_str(), &st) != 0)
-    {
-        Logger::logDebug("Daemon: State saving directory %s does not exist", m_stateDir.c_str());
-        Logger::logDebug("Daemon: Attempting to create it");
+    // Boosts are not handed over, end them now rather than never
+    decayCpuBoosts(true);
 
-        if (mkdir(m_stateDir.c_str(), S_IRUSR | S_IWUSR | S_IXUSR) != 0)
-        {
-            Logger::logDebug("Daemon: Failed to create directory, re-exec failed, exiting.");
-            _exit(1);
-        }
-    }
+    SavedState state;
+
+    // Save debug mode first, restoring it will enable debug logging.
+    // This way we get debug output from the re-execed daemon as early
+    // as possible.
+    state.add(SavedState::TAG_DEBUG_MODE, m_debugMode);
 
-    if (stat(m_stateDir.c_str(), &st) != 0)
+    // The pids of the dead boosters are also passed as children, but
+    // this causes no harm.
+    for(PidVect::iterator it = m_children.begin(); it != m_children.end(); it++)
     {
-        Logger::logDebug("Daemon: Directory vanished, re-exec failed, exiting.");
-        _exit(1);
+        state.add(SavedState::TAG_CHILD, *it);
     }
-    if (!S_ISDIR(st.st_mode))
+
+    for (TypeMap::iterator it = m_childTypes.begin(); it != m_childTypes.end(); it++)
     {
-        Logger::logDebug("Daemon: %s exists but it is not a directory, re-exec failed, exiting.", m_stateDir.c_str());
-        _exit(1);
+        state.add(SavedState::TAG_CHILD_TYPE, it->first, it->second);
     }
 
-    try {
-        std::ofstream ss(m_stateFile.c_str());
-        ss.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-
-        // dump the pid to double check that the state file is from this process
-        ss << "my-pid " << getpid() << std::endl;
+    for(PidMap::iterator it = m_boosterPidToInvokerPid.begin(); it != m_boosterPidToInvokerPid.end(); it++)
+    {
+        state.add(SavedState::TAG_BOOSTER_INVOKER_PID, it->first, it->second);
+    }
 
-        // Save debug mode first, restoring it will enable debug logging.
-        // This way we get debug output from the re-execed daemon as early
-        // as possible.
-        ss << "debug-mode " << m_debugMode << std::endl;
+    for(FdMap::iterator it = m_boosterPidToInvokerFd.begin(); it != m_boosterPidToInvokerFd.end(); it++)
+    {
+        state.add(SavedState::TAG_BOOSTER_INVOKER_FD, it->first, it->second);
+    }
 
-        // The pids of the dead boosters are also passed as children, but
-        // this causes no harm.
-        for(PidVect::iterator it = m_children.begin(); it != m_children.end(); it++)
+    for (BoosterMap::iterator it = m_boosters.begin(); it != m_boosters.end(); it++)
+    {
+        const BoosterState & booster = it->second;
+        state.add(SavedState::TAG_BOOSTER_PID, booster.pid, it->first);
+
+        // An idle booster is kept warm over the re-exec. The new daemon asks it
+        // to register and replaces it only if the ABI versions don't match.
+        // Nothing is dispatched after this point, the queued connections go
+        // to the booster only once it has registered with the new daemon.
+        if (booster.pid && !booster.busy && !booster.registering)
         {
-            ss << "child " << *it << std::endl;
+            state.add(SavedState::TAG_WARM_BOOSTER, booster.pid, BOOSTER_ABI_VERSION, it->first);
         }
 
-        for(PidMap::iterator it = m_boosterPidToInvokerPid.begin(); it != m_boosterPidToInvokerPid.end(); it++)
-        {
-            ss << "booster-invoker-pid " << it->first << " " << it->second << std::endl;
-        }
+        state.add(SavedState::TAG_LAUNCHER_SOCKET, booster.launcherSocket[0],
+                  booster.launcherSocket[1], it->first);
+        state.add(SavedState::TAG_CONNECTION_SOCKET, booster.connectionSocket[0],
+                  booster.connectionSocket[1], it->first);
 
-        for(FdMap::iterator it = m_boosterPidToInvokerFd.begin(); it != m_boosterPidToInvokerFd.end(); it++)
+        // Queued invoker connections are inherited over exec() in their order,
+        // only batch entries end with the daemon that runs the batch
+        for (ConnectionQueue::const_iterator i = booster.connectionQueue.begin();
+             i != booster.connectionQueue.end(); i++)
         {
-            ss << "booster-invoker-fd " << it->first << " " << it->second << std::endl;
+            if (!i->batch)
+            {
+                state.add(SavedState::TAG_QUEUED_CONNECTION, i->fd, i->id, i->background,
+                          it->first + '\0' + i->header);
+            }
         }
+    }
 
-        ss << "booster-pid " << m_boosterPid << std::endl;
-
-        ss << "launcher-socket " << m_boosterLauncherSocket[0] << " " << m_boosterLauncherSocket[1] << std::endl;
-
-        ss << "sigpipe-fd " << m_sigPipeFd[0] << " " << m_sigPipeFd[1] << std::endl;
+    for(InstanceMap::iterator it = m_singleInstances.begin(); it != m_singleInstances.end(); it++)
+    {
+        state.add(SavedState::TAG_SINGLE_INSTANCE, it->second, it->first);
+    }
 
-        ss << "boot-mode " << m_bootMode << std::endl;
+    state.add(SavedState::TAG_SIGPIPE_FD, m_sigPipeFd[0], m_sigPipeFd[1]);
+    state.add(SavedState::TAG_BOOT_MODE, m_bootMode);
+    state.add(SavedState::TAG_CONNECTION_COUNT, m_connectionCount);
+    state.add(SavedState::TAG_ON_DEMAND, m_onDemand);
+    state.add(SavedState::TAG_IDLE_TIMEOUT, m_idleTimeout);
+    state.add(SavedState::TAG_MEMORY_PRESSURE, m_pressureStall);
 
-        SocketManager::SocketHash s = m_socketManager->getState();
-        for(SocketManager::SocketHash::iterator it = s.begin(); it != s.end(); it++)
-        {
-            ss << "socket-hash " << it->first << " " << it->second << std::endl;
-        }
+    SocketManager::SocketHash s = m_socketManager->getState();
+    for(SocketManager::SocketHash::iterator it = s.begin(); it != s.end(); it++)
+    {
+        state.add(SavedState::TAG_SOCKET_HASH, it->second, it->first);
+    }
 
-        // when the new applauncherd reads this,
-        // it knows state saving was successful.
-        ss << "end" << std::endl;
-        ss.close();
+    int stateFd = -1;
+    try
+    {
+        stateFd = state.write();
     }
-    catch (std::ofstream::failure e)
+    catch (const std::runtime_error & e)
     {
-        Logger::logError("Daemon: Failed to save state, re-exec failed, exiting.");
+        LOGGER_ERROR("Daemon: Failed to save state, re-exec failed, exiting: %s", e.what());
         _exit(1);
     }
-    
+
+    std::ostringstream stateFdArg;
+    stateFdArg << stateFd;
+    const string stateFdStr = stateFdArg.str();
+
     char* argv[] = { const_cast<char*>("/usr/bin/applauncherd.bin"),
                      const_cast<char*>("--re-exec"),
+                     const_cast<char*>("--state-fd"),
+                     const_cast<char*>(stateFdStr.c_str()),
                      const_cast<char*>("                                                  "),
                      NULL};
 
-    // The boosters have state which will become stale, so kill them.
-    // The dead boosters will be reaped when the re-execed applauncherd
-    // calls reapZombies after it has initialized.
-    killBoosters();
+    for (BoosterMap::iterator it = m_boosters.begin(); it != m_boosters.end(); it++)
+    {
+        BoosterState & booster = it->second;
+
+        // A busy booster has state which will become stale, so kill it.
+        // The dead booster will be reaped when the re-execed applauncherd
+        // calls reapZombies after it has initialized.
+        if (booster.busy || booster.registering)
+            killProcess(booster.pid, SIGTERM);
+
+        // Batch requests can't be carried over, their invokers see the
+        // connection closing
+        for (ConnectionQueue::iterator i = booster.connectionQueue.begin();
+             i != booster.connectionQueue.end(); i++)
+        {
+            if (i->batch)
+                close(i->fd);
+        }
+        booster.connectionQueue.clear();
+    }
+
+    // Requests that are still being read can't be carried over either
+    for (ReaderVect::iterator i = m_readers.begin(); i != m_readers.end(); i++)
+        delete *i;
+    m_readers.clear();
+
+    for (BatchVect::iterator i = m_batches.begin(); i != m_batches.end(); i++)
+        delete *i;
+    m_batches.clear();
 
     // Signal handlers are reset at exec(), so we will lose
     // the SIGHUP handling. However, ignoring a signal is preserved
@@ -817,15 +1865,196 @@ void Daemon::reExec()
     // dying if we receive multiple SIGHUPs.
     signal(SIGHUP, SIG_IGN);
 
-    Logger::logDebug("Daemon: configuration saved succesfully, call execve() ");
+    LOGGER_DEBUG("Daemon: configuration saved succesfully, call execve() ");
+    Logger::flush();
     execve(argv[0], argv, environ);
 
     // Not reached.
-    Logger::logDebug("Daemon: Failed to execute execve(),  re-exec failed, exiting.");
+    LOGGER_ERROR("Daemon: Failed to execute execve(),  re-exec failed, exiting.");
     _exit(1);
 }
 
 void Daemon::restoreState()
+{
+    if (m_stateFd == -1)
+    {
+        // Re-exec from a daemon that saved its state in a file
+        restoreLegacyState();
+        return;
+    }
+
+    SavedState state;
+    try
+    {
+        state.read(m_stateFd);
+    }
+    catch (const std::runtime_error & e)
+    {
+        LOGGER_ERROR("Daemon: Failed to restore saved state, exiting: %s", e.what());
+        _exit(1);
+    }
+
+    m_stateFd = -1;
+
+    const SavedState::RecordVect & records = state.records();
+    for (SavedState::RecordVect::const_iterator i = records.begin(); i != records.end(); i++)
+    {
+        const vector<int32_t> & v = i->values;
+        const size_t count = v.size();
+
+        switch (i->tag)
+        {
+        case SavedState::TAG_DEBUG_MODE:
+            if (count < 1) break;
+            m_debugMode = v[0];
+            Logger::setDebugMode(m_debugMode);
+            LOGGER_DEBUG("Daemon: restored m_debugMode = %d", v[0]);
+            break;
+
+        case SavedState::TAG_CHILD:
+            if (count < 1) break;
+            LOGGER_DEBUG("Daemon: restored child %d", v[0]);
+            m_children.push_back(v[0]);
+            break;
+
+        case SavedState::TAG_CHILD_TYPE:
+            if (count < 1) break;
+            LOGGER_DEBUG("Daemon: restored type of child %d = %s", v[0], i->str.c_str());
+            m_childTypes[v[0]] = i->str;
+            break;
+
+        case SavedState::TAG_BOOSTER_INVOKER_PID:
+            if (count < 2) break;
+            LOGGER_DEBUG("Daemon: restored m_boosterPidToInvokerPid[%d] = %d", v[0], v[1]);
+            m_boosterPidToInvokerPid[v[0]] = v[1];
+            break;
+
+        case SavedState::TAG_BOOSTER_INVOKER_FD:
+            if (count < 2) break;
+            LOGGER_DEBUG("Daemon: restored m_boosterPidToInvokerFd[%d] = %d", v[0], v[1]);
+            m_boosterPidToInvokerFd[v[0]] = v[1];
+            break;
+
+        case SavedState::TAG_BOOSTER_PID:
+            if (count < 1) break;
+            LOGGER_DEBUG("Daemon: restored pid of booster '%s' = %d", i->str.c_str(), v[0]);
+            m_boosters[i->str].pid = v[0];
+            break;
+
+        case SavedState::TAG_SINGLE_INSTANCE:
+            if (count < 1) break;
+            LOGGER_DEBUG("Daemon: restored m_singleInstances[%s] = %d", i->str.c_str(), v[0]);
+            m_singleInstances[i->str] = v[0];
+            break;
+
+        case SavedState::TAG_LAUNCHER_SOCKET:
+            if (count < 2) break;
+            LOGGER_DEBUG("Daemon: restored launcher socket of booster '%s' = {%d, %d}",
+                         i->str.c_str(), v[0], v[1]);
+            m_boosters[i->str].launcherSocket[0] = v[0];
+            m_boosters[i->str].launcherSocket[1] = v[1];
+            break;
+
+        case SavedState::TAG_CONNECTION_SOCKET:
+            if (count < 2) break;
+            LOGGER_DEBUG("Daemon: restored connection socket of booster '%s' = {%d, %d}",
+                         i->str.c_str(), v[0], v[1]);
+            m_boosters[i->str].connectionSocket[0] = v[0];
+            m_boosters[i->str].connectionSocket[1] = v[1];
+            break;
+
+        case SavedState::TAG_SIGPIPE_FD:
+            if (count < 2) break;
+            LOGGER_DEBUG("Daemon: restored m_sigPipeFd[] = {%d, %d}", v[0], v[1]);
+            m_sigPipeFd[0] = v[0];
+            m_sigPipeFd[1] = v[1];
+            break;
+
+        case SavedState::TAG_BOOT_MODE:
+            if (count < 1) break;
+            m_bootMode = v[0];
+            LOGGER_DEBUG("Daemon: restored m_bootMode = %d", v[0]);
+            break;
+
+        case SavedState::TAG_SOCKET_HASH:
+            if (count < 1) break;
+            m_socketManager->addMapping(i->str, v[0]);
+            LOGGER_DEBUG("Daemon: restored socketHash[%s] = %d", i->str.c_str(), v[0]);
+            break;
+
+        case SavedState::TAG_CONNECTION_COUNT:
+            if (count < 1) break;
+            m_connectionCount = v[0];
+            break;
+
+        case SavedState::TAG_ON_DEMAND:
+            if (count < 1) break;
+            m_onDemand = v[0];
+            LOGGER_DEBUG("Daemon: restored m_onDemand = %d", v[0]);
+            break;
+
+        case SavedState::TAG_IDLE_TIMEOUT:
+            if (count < 1) break;
+            m_idleTimeout = v[0];
+            LOGGER_DEBUG("Daemon: restored m_idleTimeout = %d", v[0]);
+            break;
+
+        case SavedState::TAG_MEMORY_PRESSURE:
+            if (count < 1) break;
+            m_pressureStall = v[0];
+            LOGGER_DEBUG("Daemon: restored m_pressureStall = %d", v[0]);
+            break;
+
+        case SavedState::TAG_WARM_BOOSTER:
+        {
+            if (count < 2) break;
+            LOGGER_DEBUG("Daemon: restored warm booster %d, ABI version %d", v[0], v[1]);
+
+            // Nothing is handed to the booster before it has registered
+            BoosterState & booster = m_boosters[i->str];
+            booster.busy = true;
+            if (v[0] == booster.pid && v[1] == BOOSTER_ABI_VERSION)
+            {
+                booster.registering = true;
+            }
+            else
+            {
+                // The booster may not even understand the registration request
+                killProcess(booster.pid, SIGTERM);
+            }
+            break;
+        }
+
+        case SavedState::TAG_QUEUED_CONNECTION:
+        {
+            const size_t end = i->str.find('\0');
+            if (count < 3 || end == string::npos) break;
+
+            QueuedConnection connection;
+            connection.fd = v[0];
+            connection.id = v[1];
+            connection.header = i->str.substr(end + 1);
+            connection.background = v[2];
+            connection.batch = false;
+
+            // The records are in the order of the queue
+            const string type = i->str.substr(0, end);
+            LOGGER_DEBUG("Daemon: restored queued connection %d of booster '%s'", v[1], type.c_str());
+            m_boosters[type].connectionQueue.push_back(connection);
+            break;
+        }
+
+        default:
+            // State of a newer daemon that this one doesn't know about
+            LOGGER_DEBUG("Daemon: skipped saved state record %u", i->tag);
+            break;
+        }
+    }
+
+    LOGGER_DEBUG("Daemon: state restore completed");
+}
+
+void Daemon::restoreLegacyState()
 {
     try
     {
@@ -871,16 +2100,16 @@ void Daemon::restoreState()
                 // so it can be examined.
                 if (!m_debugMode && remove(m_stateFile.c_str()) == -1)
                 {
-                    Logger::logError("Daemon: could not remove state file %s", m_stateFile.c_str());
+                    LOGGER_ERROR("Daemon: could not remove state file %s", m_stateFile.c_str());
                 }
-                Logger::logDebug("Daemon: state restore completed");
+                LOGGER_DEBUG("Daemon: state restore completed");
                 return;
             } 
             else if (token == "child")
             {
                 int arg1;
                 ss >> arg1;
-                Logger::logDebug("Daemon: restored child %d", arg1);
+                LOGGER_DEBUG("Daemon: restored child %d", arg1);
                 m_children.push_back(arg1);
             } 
             else if (token == "booster-invoker-pid")
@@ -888,7 +2117,7 @@ void Daemon::restoreState()
                 int arg1, arg2;
                 ss >> arg1;
                 ss >> arg2;
-                Logger::logDebug("Daemon: restored m_boosterPidToInvokerPid[%d] = %d", arg1, arg2);
+                LOGGER_DEBUG("Daemon: restored m_boosterPidToInvokerPid[%d] = %d", arg1, arg2);
                 m_boosterPidToInvokerPid[arg1] = arg2;
             } 
             else if (token == "booster-invoker-fd")
@@ -896,32 +2125,52 @@ void Daemon::restoreState()
                 int arg1, arg2;
                 ss >> arg1;
                 ss >> arg2;
-                Logger::logDebug("Daemon: restored m_boosterPidToInvokerFd[%d] = %d", arg1, arg2);
+                LOGGER_DEBUG("Daemon: restored m_boosterPidToInvokerFd[%d] = %d", arg1, arg2);
                 m_boosterPidToInvokerFd[arg1] = arg2;
             } 
             else if (token == "booster-pid")
             {
                 int arg1;
                 ss >> arg1;
-                Logger::logDebug("Daemon: restored m_boosterPid = %d", arg1);
+                LOGGER_DEBUG("Daemon: restored booster pid = %d", arg1);
 
-                m_boosterPid = arg1;
+                // The single booster type is known when it is added
+                m_boosters[""].pid = arg1;
             } 
+            else if (token == "single-instance")
+            {
+                int arg1;
+                std::string arg2;
+                ss >> arg1;
+                ss.get();
+                std::getline(ss, arg2);
+                LOGGER_DEBUG("Daemon: restored m_singleInstances[%s] = %d", arg2.c_str(), arg1);
+                m_singleInstances[arg2] = arg1;
+            }
             else if (token == "launcher-socket")
             {
                 int arg1, arg2;
                 ss >> arg1;
                 ss >> arg2;
-                Logger::logDebug("Daemon: restored m_boosterLauncherSocket[] = {%d, %d}", arg1, arg2);
-                m_boosterLauncherSocket[0] = arg1;
-                m_boosterLauncherSocket[1] = arg2;
+                LOGGER_DEBUG("Daemon: restored booster launcher socket = {%d, %d}", arg1, arg2);
+                m_boosters[""].launcherSocket[0] = arg1;
+                m_boosters[""].launcherSocket[1] = arg2;
             } 
+            else if (token == "connection-socket")
+            {
+                int arg1, arg2;
+                ss >> arg1;
+                ss >> arg2;
+                LOGGER_DEBUG("Daemon: restored booster connection socket = {%d, %d}", arg1, arg2);
+                m_boosters[""].connectionSocket[0] = arg1;
+                m_boosters[""].connectionSocket[1] = arg2;
+            }
             else if (token == "sigpipe-fd")
             {
                 int arg1, arg2;
                 ss >> arg1;
                 ss >> arg2;
-                Logger::logDebug("Daemon: restored m_sigPipeFd[] = {%d, %d}", arg1, arg2);
+                LOGGER_DEBUG("Daemon: restored m_sigPipeFd[] = {%d, %d}", arg1, arg2);
                 m_sigPipeFd[0] = arg1;
                 m_sigPipeFd[1] = arg2;
             } 
@@ -932,7 +2181,7 @@ void Daemon::restoreState()
                 ss >> arg1;
                 ss >> arg2;
                 m_socketManager->addMapping(arg1, arg2);
-                Logger::logDebug("Daemon: restored socketHash[%s] = %d", arg1.c_str(), arg2);
+                LOGGER_DEBUG("Daemon: restored socketHash[%s] = %d", arg1.c_str(), arg2);
             }
             else if (token == "debug-mode")
             {
@@ -940,14 +2189,14 @@ void Daemon::restoreState()
                 ss >> arg1;
                 m_debugMode = arg1;
                 Logger::setDebugMode(m_debugMode);
-                Logger::logDebug("Daemon: restored m_debugMode = %d", arg1);
+                LOGGER_DEBUG("Daemon: restored m_debugMode = %d", arg1);
             }
             else if (token == "boot-mode")
             {
                 bool arg1;
                 ss >> arg1;
                 m_bootMode = arg1;
-                Logger::logDebug("Daemon: restored m_bootMode = %d", arg1);
+                LOGGER_DEBUG("Daemon: restored m_bootMode = %d", arg1);
             }
         }
     } 
@@ -955,19 +2204,19 @@ void Daemon::restoreState()
     {
         // Ran out of saved state before "end" token
         // or there was some other error in restoring the sate.
-        Logger::logError("Daemon: Failed to restore saved state, exiting."); 
+        LOGGER_ERROR("Daemon: Failed to restore saved state, exiting."); 
     }
     catch (char *err)
     {
         // Some other error, e.g. stale state file
-        Logger::logError(err);
+        LOGGER_ERROR("%s", err);
     }
 
     // In debug mode it is better to leave the file there
     // so it can be examined.
     if (!m_debugMode && remove(m_stateFile.c_str()) == -1)
     {
-        Logger::logError("Daemon: could not remove state file %s", m_stateFile.c_str());
+        LOGGER_ERROR("Daemon: could not remove state file %s", m_stateFile.c_str());
     }
 
     // This is only reached if state restore was unsuccessful.
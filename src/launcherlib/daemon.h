@@ -39,12 +39,21 @@ using std::vector;
 
 using std::map;
 
+#include <deque>
+
+using std::deque;
+
 #include <signal.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 
 class Booster;
 class SocketManager;
 class SingleInstance;
+class LaunchBatch;
+class RequestReader;
+class MemoryPressure;
 
 /*!
  * \class Daemon.
@@ -52,8 +61,14 @@ class SingleInstance;
  *
  * Daemon wraps up the daemonizing functionality and is the
  * main object of the launcher program. It runs the main loop of the
- * application, listens connections from the invoker and forks Booster
- * processes.
+ * application, accepts connections from the invoker, hands them over to
+ * Booster processes and forks new ones.
+ *
+ * A single Daemon can host several booster types. Each type has its own
+ * socket, booster process, connection queue and respawn delay. With
+ * --on-demand the booster of a type is forked only when the first
+ * connection to it arrives, and with --idle-timeout boosters that haven't
+ * been used for a while are stopped until the next connection.
  */
 class DECL_EXPORT Daemon
 {
@@ -65,8 +80,10 @@ public:
      * \param argv Argument array delivered to main()
      *
      * Supported arguments:
-     * --daemon == daemonize
-     * --help   == print usage
+     * --daemon            == daemonize
+     * --on-demand         == fork boosters on the first connection
+     * --idle-timeout SECS == stop boosters unused for SECS seconds
+     * --help              == print usage
      */
     Daemon(int & argc, char * argv[]);
 
@@ -74,7 +91,26 @@ public:
     ~Daemon();
 
     /*!
-     * \brief Run main loop and fork Boosters.
+     * \brief Host boosters of the given type.
+     * Daemon takes the ownership. Throws std::runtime_error if a booster
+     * of the same type is already hosted.
+     */
+    void addBooster(Booster *booster);
+
+    /*!
+     * \brief Host the booster types of the plugins in BOOSTER_PLUGIN_DIR.
+     * Plugins export their factory with BOOSTER_PLUGIN(). Plugins that
+     * fail to load or whose type is already hosted are skipped.
+     */
+    void loadBoosterPlugins();
+
+    /*!
+     * \brief Run main loop and fork Boosters of all hosted types.
+     */
+    void run();
+
+    /*!
+     * \brief Host boosters of the given type, run main loop and fork Boosters.
      */
     void run(Booster *booster);
 
@@ -120,8 +156,72 @@ private:
     //! Fork process that kills boosters if needed
     void forkKiller();
 
-    //! Forks and initializes a new Booster
-    void forkBooster(int sleepTime = 0);
+    //! Accepted invoker connection waiting for a booster
+    struct QueuedConnection
+    {
+        //! Connection to the invoker
+        int fd;
+
+        //! Number of the accepted invoker connection, used in the event journal
+        int id;
+
+        //! Beginning of the request already read by the daemon
+        string header;
+
+        //! True for background launches, foreground ones are handed out first
+        bool background;
+
+        //! True for an entry of a batch, its other end is held by the daemon
+        bool batch;
+    };
+
+    typedef deque<QueuedConnection> ConnectionQueue;
+
+    //! A hosted booster type and the state of its current booster process
+    struct BoosterState
+    {
+        BoosterState();
+
+        //! Booster instance, NULL if the type is known only from saved state
+        Booster * booster;
+
+        //! Current booster pid
+        pid_t pid;
+
+        //! Socket pair used to tell the parent that a new booster is needed +
+        //! some parameters.
+        int launcherSocket[2];
+
+        //! Socket pair used to hand accepted invoker connections over to the booster
+        int connectionSocket[2];
+
+        //! Invoker connections waiting for the booster
+        ConnectionQueue connectionQueue;
+
+        //! True if the current booster has been handed a connection
+        bool busy;
+
+        //! True while waiting for a booster kept over re-exec to register
+        bool registering;
+
+        //! Monotonic time in seconds the booster was forked or last took a connection
+        time_t lastActive;
+    };
+
+    //! Hosted booster types, booster type -> state
+    typedef map<string, BoosterState> BoosterMap;
+
+    //! Load a booster plugin and host its booster type
+    bool loadBoosterPlugin(const string & path);
+
+    //! Return the state of the booster type whose current booster is pid, or NULL
+    BoosterState * findBooster(pid_t pid);
+
+    //! Drop booster types known only from saved state and close their sockets
+    void removeUnhostedBoosters();
+
+    //! Forks and initializes a new Booster of the given type
+    void forkBooster(BoosterState & state, int sleepTime = 0);
 
     //! Kill given pid with SIGKILL by default
     void killProcess(pid_t pid, int signal = SIGKILL) const;
@@ -129,8 +229,50 @@ private:
     //! Load single-instance plugin
     void loadSingleInstancePlugin();
 
-    //! Read and process data from a booster pipe
-    void readFromBoosterSocket(int fd);
+    //! Read and process data from the launcher socket of a booster type
+    void readFromBoosterSocket(BoosterState & state);
+
+    //! Accept a new invoker connection for a booster type from its listening socket
+    void acceptConnection(BoosterState & state, int socketFd);
+
+    /*! \brief Read what has arrived of the request of an accepted connection
+     *  and queue the connection once enough of it has been read.
+     *  \return true if the reader is done and can be deleted.
+     */
+    bool readRequest(RequestReader & reader);
+
+    //! Return the number of connections of a booster type that are read or queued
+    size_t pendingConnections(const string & boosterType, const BoosterState & state) const;
+
+    //! Queue an accepted connection for a booster type, foreground ones before background ones
+    void queueConnection(BoosterState & state, const QueuedConnection & connection);
+
+    /*! \brief Activate an already running single-instance application and
+     *  answer its request, which has been read to the end, without a booster.
+     */
+    void answerRunningInstance(RequestReader & reader);
+
+    //! Hand queued invoker connections over to the current boosters
+    void dispatchConnections();
+
+    //! Hand queued invoker connections of a booster type over to its current booster
+    void dispatchConnections(BoosterState & state);
+
+    //! Relay the exit status of a process launched on behalf of a batch request
+    void relayBatchExit(pid_t pid, int status);
+
+    //! Delete batch requests that have nothing more to relay
+    void removeFinishedBatches();
+
+    /*! \brief Register boosterPid as the single instance of name unless
+     *  another process already is, or holds the lock file of the standalone
+     *  single-instance tool. Answers the booster with the pid of the running
+     *  instance, or 0 if boosterPid got registered.
+     */
+    void lockSingleInstance(BoosterState & state, pid_t boosterPid, const string & name);
+
+    //! Forget the single instance registration of an exited process
+    void releaseSingleInstance(pid_t pid);
 
     //! Enter normal mode (restart boosters with cache enabled)
     void enterNormalMode();
@@ -141,15 +283,43 @@ private:
     //! Kill all active boosters with -9
     void killBoosters();
 
+    //! Ask the booster kept warm over re-exec to register, or kill it if that fails
+    void requestBoosterRegistration(BoosterState & state);
+
+    /*! \brief Return the time select() may wait before an idle booster
+     *  has to be stopped, memory pressure checked again or a CPU boost
+     *  reset, NULL if there is nothing to wait for.
+     *  \param timeout Storage for the returned time.
+     */
+    struct timeval * idleTimeout(struct timeval * timeout) const;
+
+    //! Stop boosters that have been idle for m_idleTimeout seconds
+    void stopIdleBoosters();
+
+    //! Stop idle boosters when the memory pressure trigger fires
+    void evictBoosters();
+
+    //! Reset the CPU boosts of launched applications whose time is up, all if all is true
+    void decayCpuBoosts(bool all = false);
+
+    //! Fork the boosters again once memory pressure has subsided
+    void rewarmBoosters();
+
+    //! Write the memory sharing report of the boosters and launched applications
+    void writeSharingAudit();
+
     //! Prints the usage and exits with given status
     void usage(const char *name, int status);
 
     //! Re-exec applauncherd.bin
     void reExec();
 
-    //! Restore state.
+    //! Restore state handed over in m_stateFd.
     void restoreState();
 
+    //! Restore state saved as text by a daemon without --state-fd support.
+    void restoreLegacyState();
+
     //! Daemonize flag (--fork). Daemon forks if true.
     bool m_daemon;
 
@@ -168,6 +338,10 @@ private:
     typedef vector<pid_t> PidVect;
     PidVect m_children;
 
+    //! Booster types of the children
+    typedef map<pid_t, string> TypeMap;
+    TypeMap m_childTypes;
+
     //! Storage of booster <-> invoker pid pairs
     typedef map<pid_t, pid_t> PidMap;
     PidMap m_boosterPidToInvokerPid;
@@ -176,12 +350,29 @@ private:
     typedef map<pid_t, pid_t> FdMap;
     FdMap m_boosterPidToInvokerFd;
 
-    //! Current booster pid
-    pid_t m_boosterPid;
+    //! Hosted booster types
+    BoosterMap m_boosters;
+
+    /*! Maximum number of queued connections per booster type, including
+     *  the ones whose request is still being read. New connections are
+     *  left in the listen backlog while the queue is full.
+     */
+    static const size_t MAX_QUEUED_CONNECTIONS = 128;
+
+    //! Number of invoker connections accepted so far
+    int m_connectionCount;
+
+    //! Accepted connections whose request is being read
+    typedef vector<RequestReader *> ReaderVect;
+    ReaderVect m_readers;
 
-    //! Socket pair used to tell the parent that a new booster is needed +
-    //! some parameters.
-    int m_boosterLauncherSocket[2];
+    //! Batch launch requests in progress
+    typedef vector<LaunchBatch *> BatchVect;
+    BatchVect m_batches;
+
+    //! Running single-instance applications, application name -> pid
+    typedef map<string, pid_t> InstanceMap;
+    InstanceMap m_singleInstances;
 
     //! Pipe used to safely catch Unix signals
     int m_sigPipeFd[2];
@@ -195,9 +386,6 @@ private:
     //! Singleton Daemon instance
     static Daemon * m_instance;
 
-    //! Time to sleep before forking a new booster
-    static const int m_boosterSleepTime;
-
     //! Manager for invoker <-> booster sockets
     SocketManager * m_socketManager;
 
@@ -211,13 +399,50 @@ private:
     //! True if re-execing
     bool m_reExec;
 
+    //! Descriptor of the state handed over in re-exec (--state-fd), -1 if none
+    int m_stateFd;
+
     //! True if systemd needs to be notified
     bool m_notifySystemd;
 
-    //! Booster instance
-    Booster * m_booster;
+    //! True if boosters are forked only when connections arrive (--on-demand)
+    bool m_onDemand;
+
+    //! Seconds after which idle boosters are stopped (--idle-timeout), 0 if never
+    int m_idleTimeout;
+
+    //! Memory stall in ms per second that evicts idle boosters (--memory-pressure), 0 if none
+    int m_pressureStall;
+
+    //! PSI trigger of m_pressureStall
+    MemoryPressure * m_memoryPressure;
+
+    //! True while boosters are evicted for memory pressure
+    bool m_underPressure;
+
+    //! Time memory pressure was last seen or checked
+    time_t m_pressureChecked;
+
+    //! Launch-time CPU boost of an application
+    struct CpuBoost
+    {
+        pid_t pid;
+
+        //! uclamp.min in percent
+        int percent;
+
+        //! Monotonic time in milliseconds the boost ends
+        long long end;
+    };
+
+    //! CPU boosts to reset
+    typedef vector<CpuBoost> CpuBoostVect;
+    CpuBoostVect m_cpuBoosts;
+
+    //! Seconds between checks whether memory pressure has subsided
+    static const int PRESSURE_CHECK_INTERVAL = 5;
 
-    //! Name of the state saving directory and file
+    //! Name of the state saving directory and file of daemons without --state-fd
     static const std::string m_stateDir;
     static const std::string m_stateFile;
 
@@ -0,0 +1,133 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "eventlog.h"
+#include "logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+launch_events_header * EventLog::m_header = NULL;
+launch_event * EventLog::m_events = NULL;
+
+//! Size of the journal file
+static const size_t JOURNAL_SIZE = sizeof(launch_events_header) +
+                                   LAUNCH_EVENTS_CAPACITY * sizeof(launch_event);
+
+bool EventLog::open(const string & path)
+{
+    EventLog::close();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        LOGGER_WARNING("EventLog: Failed to open '%s': %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    bool fresh = fstat(fd, &st) != 0 || st.st_size != static_cast<off_t>(JOURNAL_SIZE);
+    if (fresh && (ftruncate(fd, 0) != 0 || ftruncate(fd, JOURNAL_SIZE) != 0))
+    {
+        LOGGER_WARNING("EventLog: Failed to resize '%s': %s", path.c_str(), strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    void * map = mmap(NULL, JOURNAL_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        LOGGER_WARNING("EventLog: Failed to map '%s': %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    m_header = static_cast<launch_events_header *>(map);
+    m_events = reinterpret_cast<launch_event *>(m_header + 1);
+
+    // Start over if the file is not a journal of this format
+    if (fresh || m_header->magic != LAUNCH_EVENTS_MAGIC ||
+        m_header->capacity != LAUNCH_EVENTS_CAPACITY)
+    {
+        memset(map, 0, JOURNAL_SIZE);
+        m_header->capacity = LAUNCH_EVENTS_CAPACITY;
+        __sync_synchronize();
+        m_header->magic = LAUNCH_EVENTS_MAGIC;
+    }
+
+    return true;
+}
+
+void EventLog::close()
+{
+    if (m_header)
+    {
+        munmap(m_header, JOURNAL_SIZE);
+        m_header = NULL;
+        m_events = NULL;
+    }
+}
+
+void EventLog::record(launch_event_type type, pid_t pid, int value, const char * app)
+{
+    if (!m_header)
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // Reserve a record, shared with the other processes mapping the file
+    const uint64_t index = __sync_fetch_and_add(&m_header->next, 1);
+    launch_event & event = m_events[index % LAUNCH_EVENTS_CAPACITY];
+
+    // Invalidate the record while it is being written
+    event.sequence = 0;
+    __sync_synchronize();
+
+    event.timestamp = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+    event.pid       = pid;
+    event.type      = type;
+    event.value     = value;
+    event.reserved  = 0;
+
+    if (app)
+    {
+        const char * name = strrchr(app, '/');
+        name = name ? name + 1 : app;
+
+        // The name is not terminated if it fills the whole field
+        const size_t length = strnlen(name, sizeof(event.app));
+        memcpy(event.app, name, length);
+        if (length < sizeof(event.app))
+            event.app[length] = '\0';
+    }
+    else
+    {
+        event.app[0] = '\0';
+    }
+
+    __sync_synchronize();
+    event.sequence = index + 1;
+}
@@ -0,0 +1,71 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "launcherlib.h"
+#include "launchevents.h"
+
+#include <sys/types.h>
+#include <string>
+
+using std::string;
+
+/*!
+ * \class EventLog
+ * \brief Writer of the binary launch event journal.
+ *
+ * The journal is a ring of fixed-size records in a file mapped shared by
+ * the daemon and the boosters it forks, see launchevents.h. Recording an
+ * event doesn't involve any system calls apart from reading the clock.
+ */
+class DECL_EXPORT EventLog
+{
+public:
+
+    /*!
+     * \brief Map the journal file at path, creating it if needed.
+     *        A file left behind by a previous daemon is appended to.
+     * \return false if the journal is not available.
+     */
+    static bool open(const string & path);
+
+    //! Unmap the journal
+    static void close();
+
+    /*!
+     * \brief Append an event to the journal, if it is open.
+     * \param type Event type
+     * \param pid Process the event concerns
+     * \param value Type specific value
+     * \param app Application binary, only its basename is stored
+     */
+    static void record(launch_event_type type, pid_t pid, int value = 0, const char * app = 0);
+
+private:
+
+    //! Header of the mapped journal, NULL if not open
+    static launch_events_header * m_header;
+
+    //! Records of the mapped journal
+    static launch_event * m_events;
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,277 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "launchbatch.h"
+#include "logger.h"
+#include "protocol.h"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <algorithm>
+
+LaunchBatch::LaunchBatch(int invokerFd, uint32_t magic, const int io[3],
+                         const vector<string> & entries) :
+    m_fd(invokerFd),
+    m_options(magic & INVOKER_MSG_MAGIC_OPTION_MASK & ~INVOKER_MSG_MAGIC_OPTION_BATCH)
+{
+    m_io[0] = io[0];
+    m_io[1] = io[1];
+    m_io[2] = io[2];
+
+    for (unsigned int i = 0; i < entries.size(); i++)
+    {
+        Entry entry;
+        entry.fd        = -1;
+        entry.data      = entries[i];
+        entry.replySize = 0;
+        entry.pid       = 0;
+        entry.done      = false;
+        m_entries.push_back(entry);
+    }
+}
+
+LaunchBatch::~LaunchBatch()
+{
+    closeAll();
+}
+
+void LaunchBatch::closeAll()
+{
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].fd != -1)
+        {
+            close(m_entries[i].fd);
+            m_entries[i].fd = -1;
+        }
+        m_entries[i].done = true;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (m_io[i] != -1)
+        {
+            close(m_io[i]);
+            m_io[i] = -1;
+        }
+    }
+
+    if (m_fd != -1)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void LaunchBatch::start(deque<int> & connections)
+{
+    if (!(m_options & INVOKER_MSG_MAGIC_OPTION_NO_ACK))
+    {
+        uint32_t ack = INVOKER_MSG_ACK;
+        send(m_fd, &ack, sizeof(ack), MSG_NOSIGNAL);
+    }
+
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        int fd = createRequest(m_entries[i]);
+        if (fd == -1)
+        {
+            LOGGER_ERROR("LaunchBatch: can't create launch request for entry %u", i);
+            sendToInvoker(INVOKER_MSG_BATCH_EXIT, i, EXIT_FAILURE);
+            m_entries[i].done = true;
+        }
+        else
+        {
+            connections.push_back(fd);
+        }
+
+        // The request has been written, no need to keep it around
+        string().swap(m_entries[i].data);
+    }
+
+    LOGGER_DEBUG("LaunchBatch: started %u entries", static_cast<unsigned int>(m_entries.size()));
+}
+
+int LaunchBatch::createRequest(Entry & entry)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+        return -1;
+
+    // Boosters always send the pid of the application, because that is
+    // the only way to find out which application each of them launched.
+    uint32_t header = INVOKER_MSG_MAGIC | INVOKER_MSG_MAGIC_VERSION |
+        ((m_options | INVOKER_MSG_MAGIC_OPTION_WAIT) & ~INVOKER_MSG_MAGIC_OPTION_NO_ACK);
+
+    string request(reinterpret_cast<const char *>(&header), sizeof(header));
+    request += entry.data;
+
+    bool ok = write(sv[0], request.data(), request.size()) == static_cast<ssize_t>(request.size());
+
+    if (ok && m_io[0] != -1)
+    {
+        uint32_t action = INVOKER_MSG_IO;
+        ok = write(sv[0], &action, sizeof(action)) == sizeof(action);
+
+        char dummy = 0;
+        struct iovec iov;
+        iov.iov_base = &dummy;
+        iov.iov_len  = 1;
+
+        char buf[CMSG_SPACE(sizeof(m_io))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = buf;
+        msg.msg_controllen = sizeof(buf);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(m_io));
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        memcpy(CMSG_DATA(cmsg), m_io, sizeof(m_io));
+
+        ok = ok && sendmsg(sv[0], &msg, 0) >= 0;
+    }
+
+    if (ok)
+    {
+        uint32_t action = INVOKER_MSG_END;
+        ok = write(sv[0], &action, sizeof(action)) == sizeof(action);
+    }
+
+    if (!ok)
+    {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    entry.fd = sv[0];
+    return sv[1];
+}
+
+void LaunchBatch::addToFdSet(fd_set * fds, int * ndfs) const
+{
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].fd != -1)
+        {
+            FD_SET(m_entries[i].fd, fds);
+            *ndfs = std::max(*ndfs, m_entries[i].fd);
+        }
+    }
+}
+
+void LaunchBatch::handleFdSet(const fd_set * fds)
+{
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].fd != -1 && FD_ISSET(m_entries[i].fd, fds))
+            receivePid(i);
+    }
+}
+
+void LaunchBatch::receivePid(unsigned int index)
+{
+    Entry & entry = m_entries[index];
+
+    // The booster sends ACK, INVOKER_MSG_PID and the pid. Collect them
+    // without blocking, the rest may arrive on a later select().
+    char * buf = reinterpret_cast<char *>(entry.reply);
+    ssize_t ret = recv(entry.fd, buf + entry.replySize,
+                       sizeof(entry.reply) - entry.replySize, MSG_DONTWAIT);
+
+    if (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+
+    if (ret > 0)
+    {
+        entry.replySize += ret;
+        if (entry.replySize < sizeof(entry.reply))
+            return;
+    }
+
+    close(entry.fd);
+    entry.fd = -1;
+
+    if (entry.replySize == sizeof(entry.reply) && entry.reply[0] == INVOKER_MSG_ACK &&
+        entry.reply[1] == INVOKER_MSG_PID && entry.reply[2] != 0)
+    {
+        entry.pid = entry.reply[2];
+        sendToInvoker(INVOKER_MSG_BATCH_PID, index, entry.pid);
+
+        if (!(m_options & INVOKER_MSG_MAGIC_OPTION_WAIT))
+            entry.done = true;
+    }
+    else
+    {
+        LOGGER_ERROR("LaunchBatch: booster failed to launch entry %u", index);
+        sendToInvoker(INVOKER_MSG_BATCH_EXIT, index, EXIT_FAILURE);
+        entry.done = true;
+    }
+}
+
+bool LaunchBatch::childExited(pid_t pid, int status)
+{
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].pid == pid && !m_entries[i].done)
+        {
+            // Report deaths by a signal the way shells do
+            int exitStatus = EXIT_FAILURE;
+            if (WIFEXITED(status))
+                exitStatus = WEXITSTATUS(status);
+            else if (WIFSIGNALED(status))
+                exitStatus = 128 + WTERMSIG(status);
+
+            sendToInvoker(INVOKER_MSG_BATCH_EXIT, i, exitStatus);
+            m_entries[i].done = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool LaunchBatch::finished() const
+{
+    for (unsigned int i = 0; i < m_entries.size(); i++)
+    {
+        if (!m_entries[i].done)
+            return false;
+    }
+
+    return true;
+}
+
+void LaunchBatch::sendToInvoker(uint32_t msg, uint32_t index, uint32_t value)
+{
+    if (m_options & INVOKER_MSG_MAGIC_OPTION_NO_ACK)
+        return;
+
+    uint32_t buf[3] = {msg, index, value};
+    if (send(m_fd, buf, sizeof(buf), MSG_NOSIGNAL) != sizeof(buf))
+        LOGGER_WARNING("LaunchBatch: can't send %08x for entry %u to invoker", msg, index);
+}
@@ -0,0 +1,151 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef LAUNCHBATCH_H
+#define LAUNCHBATCH_H
+
+#include "launcherlib.h"
+#include "protocol.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/select.h>
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+#include <deque>
+
+using std::deque;
+
+/*!
+ * \class LaunchBatch
+ * \brief Daemon side of a batch launch request.
+ *
+ * A batch request carries several application descriptors on a single
+ * invoker connection. RequestReader reads the request and LaunchBatch
+ * takes over from there. Each descriptor is turned into an ordinary launch
+ * request written to a private socket pair, and the other end of the pair
+ * is handed over to a booster just like an accepted invoker connection.
+ * PIDs and exit statuses of the launched applications are relayed back
+ * to the invoker, tagged with the index of the descriptor.
+ */
+class LaunchBatch
+{
+public:
+
+    //! Maximum number of applications in one batch
+    static const uint32_t MAX_ENTRIES = INVOKER_BATCH_MAX_ENTRIES;
+
+    //! Maximum size of one application descriptor in bytes
+    static const uint32_t MAX_ENTRY_SIZE = 65536;
+
+    /*! \brief Constructor.
+     *  \param invokerFd Invoker connection the request was read from.
+     *  \param magic Magic number of the request.
+     *  \param io Shared I/O descriptors, -1 if none.
+     *  \param entries Messages of each application, starting with INVOKER_MSG_NAME.
+     *  LaunchBatch takes the ownership of all descriptors.
+     */
+    LaunchBatch(int invokerFd, uint32_t magic, const int io[3], const vector<string> & entries);
+
+    //! Destructor
+    ~LaunchBatch();
+
+    /*! \brief Acknowledge the request and build a launch request for each
+     *  application. The booster ends of them are appended to connections,
+     *  the caller takes the ownership of the appended descriptors.
+     */
+    void start(deque<int> & connections);
+
+    //! Add the descriptors waiting for booster replies to the select() set
+    void addToFdSet(fd_set * fds, int * ndfs) const;
+
+    //! Relay PIDs from boosters whose descriptors are set in fds
+    void handleFdSet(const fd_set * fds);
+
+    /*! \brief Relay the exit status of a launched application.
+     *  \return true if pid was launched by this batch.
+     */
+    bool childExited(pid_t pid, int status);
+
+    //! Return true when there is nothing more to relay to the invoker
+    bool finished() const;
+
+    //! Close all descriptors without relaying anything, used in forked boosters
+    void closeAll();
+
+private:
+
+    //! Disable copy-constructor
+    LaunchBatch(const LaunchBatch & r);
+
+    //! Disable assignment operator
+    LaunchBatch & operator= (const LaunchBatch & r);
+
+    //! State of one application in the batch
+    struct Entry
+    {
+        //! Daemon end of the launch request, -1 once the PID is known
+        int fd;
+
+        //! Application data excluding I/O descriptors and END
+        string data;
+
+        //! Reply of the booster: ACK, INVOKER_MSG_PID and the pid
+        uint32_t reply[3];
+
+        //! Number of reply bytes received so far
+        size_t replySize;
+
+        //! PID of the application, 0 if not launched (yet)
+        pid_t pid;
+
+        //! True if nothing more is to be relayed for this entry
+        bool done;
+    };
+
+    //! Write the launch request of entry to a new socket pair, return the booster end
+    int createRequest(Entry & entry);
+
+    //! Read the reply of the booster launching the entry at index
+    void receivePid(unsigned int index);
+
+    //! Send message followed by two values to the invoker
+    void sendToInvoker(uint32_t msg, uint32_t index, uint32_t value);
+
+    //! Connection to the invoker
+    int m_fd;
+
+    //! Options from the magic number
+    uint32_t m_options;
+
+    //! I/O descriptors shared by all applications, -1 if not sent
+    int m_io[3];
+
+    //! Applications of the batch
+    vector<Entry> m_entries;
+};
+
+#endif // LAUNCHBATCH_H
@@ -22,12 +22,28 @@
 #include <syslog.h>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
+#include <stdint.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 
 #include "coverage.h"
 
+//! Native protocol socket of systemd-journald
+static const char * const JOURNAL_SOCKET = "/run/systemd/journal/socket";
+
 bool Logger::m_isOpened  = false;
 bool Logger::m_debugMode = false;
+bool Logger::m_buffered  = false;
+const char * Logger::m_progName = "mapplauncherd";
+int Logger::m_journalFd = -1;
+bool Logger::m_journalUnavailable = false;
+Logger::Entry Logger::m_ring[Logger::RING_SIZE];
+unsigned int Logger::m_first = 0;
+unsigned int Logger::m_count = 0;
 
 void Logger::openLog(const char * progName)
 {
@@ -36,37 +52,174 @@ void Logger::openLog(const char * progName)
 
     if (Logger::m_isOpened)
     {
-        Logger::closeLog();
+        closelog();
     }
+    Logger::m_progName = progName;
     openlog(progName, LOG_PID, LOG_DAEMON);
     Logger::m_isOpened = true;
 }
 
 void Logger::closeLog()
 {
+    // Nothing may be left behind as the log descriptors go away
+    Logger::flush();
+
     if (Logger::m_isOpened)
     {
         // Close syslog
         closelog();
         Logger::m_isOpened = false;
     }
+
+    if (Logger::m_journalFd != -1)
+    {
+        close(Logger::m_journalFd);
+        Logger::m_journalFd = -1;
+    }
 }
 
-void Logger::writeLog(const int priority, const char * format, va_list ap) 
+bool Logger::openJournal()
 {
-    // In debug mode everything is printed also to stdout
-    if (m_debugMode)
+    if (Logger::m_journalFd != -1)
+        return true;
+
+    if (Logger::m_journalUnavailable)
+        return false;
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd != -1)
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, JOURNAL_SOCKET, sizeof(addr.sun_path) - 1);
+
+        if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0)
+        {
+            Logger::m_journalFd = fd;
+            return true;
+        }
+
+        close(fd);
+    }
+
+    // Don't retry for every message, syslog is used from now on
+    Logger::m_journalUnavailable = true;
+    return false;
+}
+
+bool Logger::sendToJournal(const Entry & entry)
+{
+    if (!Logger::openJournal())
+        return false;
+
+    char header[128];
+    int headerLength = snprintf(header, sizeof(header),
+                                "PRIORITY=%d\nSYSLOG_FACILITY=%d\nSYSLOG_IDENTIFIER=",
+                                entry.priority, LOG_DAEMON >> 3);
+    if (headerLength < 0 || headerLength >= static_cast<int>(sizeof(header)))
+        return false;
+
+    // The message may contain newlines, so it is sent as a binary field:
+    // name, newline, little-endian 64-bit length, data and a newline.
+    char messageHeader[9 + sizeof(uint64_t)];
+    memcpy(messageHeader, "\nMESSAGE\n", 9);
+    uint64_t length = entry.length;
+    for (unsigned int i = 0; i < sizeof(uint64_t); i++)
+        messageHeader[9 + i] = static_cast<char>((length >> (8 * i)) & 0xff);
+
+    struct iovec iov[5];
+    iov[0].iov_base = header;
+    iov[0].iov_len  = headerLength;
+    iov[1].iov_base = const_cast<char *>(Logger::m_progName);
+    iov[1].iov_len  = strlen(Logger::m_progName);
+    iov[2].iov_base = messageHeader;
+    iov[2].iov_len  = 9 + sizeof(uint64_t);
+    iov[3].iov_base = const_cast<char *>(entry.text);
+    iov[3].iov_len  = entry.length;
+    iov[4].iov_base = const_cast<char *>("\n");
+    iov[4].iov_len  = 1;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = 5;
+
+    // Never block the daemon on a congested journal, syslog takes over instead
+    return sendmsg(Logger::m_journalFd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0;
+}
+
+void Logger::flush()
+{
+    while (Logger::m_count > 0)
     {
-        vprintf(format, ap);
-        printf("\n");
+        const Entry & entry = Logger::m_ring[Logger::m_first];
+
+        // In debug mode everything is printed also to stdout
+        if (m_debugMode)
+        {
+            printf("%s\n", entry.text);
+        }
+
+        if (!Logger::sendToJournal(entry))
+        {
+            // Print to syslog
+            if (!Logger::m_isOpened)
+            {
+                Logger::openLog(); //open log with default name
+            }
+            syslog(entry.priority, "%s", entry.text);
+        }
+
+        Logger::m_first = (Logger::m_first + 1) % RING_SIZE;
+        Logger::m_count--;
     }
 
-    // Print to syslog
-    if (!Logger::m_isOpened)
+    if (m_debugMode)
+        fflush(stdout);
+}
+
+void Logger::setBuffered(bool enable)
+{
+    static bool flushAtExit = false;
+    if (enable && !flushAtExit)
     {
-        Logger::openLog(); //open log with default name
+        atexit(Logger::flush);
+        flushAtExit = true;
     }
-    vsyslog(priority, format, ap);
+
+    Logger::m_buffered = enable;
+    if (!enable)
+        Logger::flush();
+}
+
+void Logger::writeLog(const int priority, const char * format, va_list ap) 
+{
+    // Make room by writing out the oldest messages
+    if (Logger::m_count == RING_SIZE)
+        Logger::flush();
+
+    Entry & entry = Logger::m_ring[(Logger::m_first + Logger::m_count) % RING_SIZE];
+    Logger::m_count++;
+
+    entry.priority = priority;
+    int length = vsnprintf(entry.text, sizeof(entry.text), format, ap);
+    if (length < 0)
+        length = 0;
+    else if (length >= static_cast<int>(sizeof(entry.text)))
+        length = sizeof(entry.text) - 1;
+
+    // Trailing newlines are added by the log itself
+    while (length > 0 && entry.text[length - 1] == '\n')
+        entry.text[--length] = '\0';
+
+    entry.length = length;
+
+    // Errors are written out right away as the process may be about to die
+    if (!Logger::m_buffered || priority <= LOG_ERR)
+        Logger::flush();
 }
 
 void Logger::logDebug(const char * format, ...)
@@ -86,8 +239,6 @@ void Logger::logInfo(const char * format, ...)
     va_start(ap, format);
     writeLog(LOG_INFO, format, ap); 
     va_end(ap);
-    // To avoid extra file descriptors in forked boosters closing connection to syslog
-    Logger::closeLog();
 }
 
 void Logger::logWarning(const char * format, ...)
@@ -21,12 +21,25 @@
 #define LOGGER_H
 
 #include "launcherlib.h"
+#include "loglevel.h"
 #include <cstdarg>
+#include <cstddef>
+
+#ifdef __GNUC__
+#define LOGGER_PRINTF_FORMAT __attribute__((format(printf, 1, 2)))
+#else
+#define LOGGER_PRINTF_FORMAT
+#endif
 
 /*!
  * \class Logger
  * \brief Logging utility class
  *
+ * Messages are formatted into a preallocated ring buffer and written out
+ * in batches by flush(), which the daemon calls from its event loop when
+ * it is about to go idle. Errors, a full buffer and an unbuffered logger
+ * flush immediately. Batches are sent to journald's native socket when it
+ * is available and to syslog otherwise.
  */
 class DECL_EXPORT Logger
 {
@@ -40,9 +53,21 @@ public:
 
     /*!
      * \brief Close the log
+     * Pending messages are flushed and all log descriptors are closed.
      */
     static void closeLog();
 
+    /*!
+     * \brief Write out pending messages
+     */
+    static void flush();
+
+    /*!
+     * \brief Keep messages in the ring buffer until flush() if set to true.
+     *        By default every message is written out immediately.
+     */
+    static void setBuffered(bool enable);
+
     /*!
      * \brief Log a debug to the system message logger.
      *        Effective only if Logger::setDebugMode(true) called;
@@ -51,7 +76,7 @@ public:
      *        sequence of additional arguments, each containing one value to be inserted
      *        in the format parameter, if any. 
      */
-    static void logDebug(const char * format, ...);
+    static void logDebug(const char * format, ...) LOGGER_PRINTF_FORMAT;
 
     /*!
      * \brief Log an error to the system message logger
@@ -60,7 +85,7 @@ public:
      *        sequence of additional arguments, each containing one value to be inserted
      *        in the format parameter, if any. 
      */
-    static void logError(const char * format, ...);
+    static void logError(const char * format, ...) LOGGER_PRINTF_FORMAT;
 
     /*!
      * \brief Log a warning to the system message logger
@@ -69,7 +94,7 @@ public:
      *        sequence of additional arguments, each containing one value to be inserted
      *        in the format parameter, if any. 
      */
-    static void logWarning(const char * format, ...);
+    static void logWarning(const char * format, ...) LOGGER_PRINTF_FORMAT;
 
     /*!
      * \brief Log a piece of information to the system message logger
@@ -78,27 +103,84 @@ public:
      *        sequence of additional arguments, each containing one value to be inserted
      *        in the format parameter, if any. 
      */
-    static void logInfo(const char * format, ...);
+    static void logInfo(const char * format, ...) LOGGER_PRINTF_FORMAT;
 
     /*!
      * \brief Forces Logger to log everything and echo to stdout if set to true.
      */
     static void setDebugMode(bool enable);
 
+    //! Return true if debug messages are logged
+    static bool debugMode() { return m_debugMode; }
+
 private:
 
+    //! Number of messages the ring buffer can hold
+    static const unsigned int RING_SIZE = 64;
+
+    //! Maximum length of a single formatted message
+    static const unsigned int MESSAGE_MAX = 512;
+
+    //! A formatted message waiting in the ring buffer
+    struct Entry
+    {
+        int    priority;
+        size_t length;
+        char   text[MESSAGE_MAX];
+    };
+
     static void writeLog(const int priority, const char * format, va_list ap); 
 
+    //! Send entry to journald, return false if that is not possible
+    static bool sendToJournal(const Entry & entry);
+
+    //! Connect to journald's native socket, return false if unavailable
+    static bool openJournal();
+
     //! True if the log is open
     static bool m_isOpened;
 
     //! Echo everything including debug messages to stdout if true
     static bool m_debugMode;
 
+    //! Keep messages until flush() if true
+    static bool m_buffered;
+
+    //! Program name as it will be seen in the log
+    static const char * m_progName;
+
+    //! Socket connected to journald, -1 if not connected
+    static int m_journalFd;
+
+    //! True if connecting to journald failed, syslog is used instead
+    static bool m_journalUnavailable;
+
+    //! Ring buffer of formatted messages
+    static Entry m_ring[RING_SIZE];
+
+    //! Index of the oldest pending message
+    static unsigned int m_first;
+
+    //! Number of pending messages
+    static unsigned int m_count;
+
 #ifdef UNIT_TEST
     friend class Ut_Logger;
 #endif
 };
 
+/*
+ * Logging macros. Unlike the Logger functions, they evaluate their
+ * arguments only if the message is going to be logged: levels above
+ * LOGLEVEL_MAX are compiled out and debug and trace messages are
+ * checked against the debug mode first. Trace messages are for
+ * per-message protocol dumps and they are compiled out by default.
+ */
+#define LOGGER_ERROR(...)   LOGLEVEL_ERROR_CALL(true, Logger::logError(__VA_ARGS__))
+#define LOGGER_WARNING(...) LOGLEVEL_WARNING_CALL(true, Logger::logWarning(__VA_ARGS__))
+#define LOGGER_INFO(...)    LOGLEVEL_INFO_CALL(true, Logger::logInfo(__VA_ARGS__))
+#define LOGGER_DEBUG(...)   LOGLEVEL_DEBUG_CALL(Logger::debugMode(), Logger::logDebug(__VA_ARGS__))
+#define LOGGER_TRACE(...)   LOGLEVEL_TRACE_CALL(Logger::debugMode(), Logger::logDebug(__VA_ARGS__))
+
 #endif // LOGGER_H
 
@@ -0,0 +1,97 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "memorypressure.h"
+#include "logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char * const PRESSURE_FILE = "/proc/pressure/memory";
+
+// Window of the trigger in microseconds. Unprivileged processes may
+// only use multiples of two seconds.
+static const int PRESSURE_WINDOW = 2000000;
+
+MemoryPressure::MemoryPressure() :
+    m_fd(-1)
+{}
+
+MemoryPressure::~MemoryPressure()
+{
+    close();
+}
+
+bool MemoryPressure::watch(int stallMs)
+{
+    close();
+
+    m_fd = open(PRESSURE_FILE, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd == -1)
+    {
+        LOGGER_WARNING("MemoryPressure: can't open %s: %s", PRESSURE_FILE, strerror(errno));
+        return false;
+    }
+
+    char trigger[64];
+    const int length = snprintf(trigger, sizeof(trigger), "some %d %d",
+                                stallMs * (PRESSURE_WINDOW / 1000000) * 1000, PRESSURE_WINDOW);
+
+    // The terminating null is part of the trigger
+    if (write(m_fd, trigger, length + 1) == -1)
+    {
+        LOGGER_WARNING("MemoryPressure: can't set trigger '%s': %s", trigger, strerror(errno));
+        close();
+        return false;
+    }
+
+    LOGGER_DEBUG("MemoryPressure: watching '%s'", trigger);
+    return true;
+}
+
+int MemoryPressure::fd() const
+{
+    return m_fd;
+}
+
+void MemoryPressure::close()
+{
+    if (m_fd != -1)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+double MemoryPressure::someAverage()
+{
+    FILE * file = fopen(PRESSURE_FILE, "re");
+    if (!file)
+        return -1;
+
+    double average = -1;
+    if (fscanf(file, "some avg10=%lf", &average) != 1)
+        average = -1;
+
+    fclose(file);
+    return average;
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef MEMORYPRESSURE_H
+#define MEMORYPRESSURE_H
+
+/*!
+ * \class MemoryPressure
+ * \brief Watches memory pressure with a PSI trigger on /proc/pressure/memory.
+ *
+ * The trigger descriptor gets an exceptional condition, the one select()
+ * reports in its exceptfds, when tasks have stalled on memory for longer
+ * than the given time per second, measured over a window of two seconds.
+ */
+class MemoryPressure
+{
+public:
+
+    //! Constructor
+    MemoryPressure();
+
+    //! Destructor
+    ~MemoryPressure();
+
+    /*! \brief Create the trigger.
+     *  \param stallMs Stall time in milliseconds per second that fires the trigger.
+     *  \return false if the kernel doesn't support pressure stall information.
+     */
+    bool watch(int stallMs);
+
+    //! Return the trigger descriptor, -1 if not watching
+    int fd() const;
+
+    //! Close the trigger
+    void close();
+
+    /*! \brief Return the share of time in percent some tasks stalled on memory
+     *  during the last ten seconds (avg10), -1 if not available.
+     */
+    static double someAverage();
+
+private:
+
+    //! Disable copy-constructor
+    MemoryPressure(const MemoryPressure & r);
+
+    //! Disable assignment operator
+    MemoryPressure & operator= (const MemoryPressure & r);
+
+    //! Trigger descriptor
+    int m_fd;
+};
+
+#endif // MEMORYPRESSURE_H
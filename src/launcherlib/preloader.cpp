@@ -0,0 +1,712 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "preloader.h"
+#include "logger.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <link.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#ifndef MADV_COLLAPSE
+#define MADV_COLLAPSE 25
+#endif
+
+//! Magic number of RELRO snapshot files
+static const uint32_t RELRO_MAGIC = 0x52454c52;
+
+//! Header of a RELRO snapshot file, the snapshot starts at the next page
+struct RelroHeader
+{
+    uint32_t magic;
+    uint32_t headerSize;
+    uint64_t mtime;
+    uint64_t start;
+    uint64_t size;
+};
+
+//! Page aligned RELRO region of a loaded object
+struct RelroRegion
+{
+    uintptr_t start;
+    size_t size;
+};
+
+//! Loaded object looked up with dl_iterate_phdr()
+struct LoadedObject
+{
+    const char * name;
+    ElfW(Addr) base;
+    struct dl_phdr_info info;
+};
+
+// dl_iterate_phdr() callback copying the program header info of the
+// object whose name and base address are given in data
+static int findObject(struct dl_phdr_info * info, size_t size, void * data)
+{
+    LoadedObject * object = static_cast<LoadedObject *>(data);
+    if (info->dlpi_addr != object->base || strcmp(info->dlpi_name, object->name) != 0)
+        return 0;
+
+    memcpy(&object->info, info, size < sizeof(object->info) ? size : sizeof(object->info));
+    return 1;
+}
+
+// Find the program headers of the object loaded with handle
+static bool findLoadedObject(void * handle, struct dl_phdr_info & info)
+{
+    struct link_map * map = NULL;
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0 || !map)
+        return false;
+
+    LoadedObject object;
+    memset(&object, 0, sizeof(object));
+    object.name = map->l_name;
+    object.base = map->l_addr;
+    if (!dl_iterate_phdr(findObject, &object))
+        return false;
+
+    info = object.info;
+    return true;
+}
+
+// Return the RELRO region of the object, the dynamic linker
+// write-protects whole pages only
+static RelroRegion relroRegion(const struct dl_phdr_info & info)
+{
+    RelroRegion region = {0, 0};
+    for (int i = 0; i < info.dlpi_phnum; i++)
+    {
+        if (info.dlpi_phdr[i].p_type == PT_GNU_RELRO)
+        {
+            const uintptr_t pageSize = getpagesize();
+            const uintptr_t begin = info.dlpi_addr + info.dlpi_phdr[i].p_vaddr;
+            const uintptr_t end = (begin + info.dlpi_phdr[i].p_memsz) & ~(pageSize - 1);
+            region.start = begin & ~(pageSize - 1);
+            region.size = end > region.start ? end - region.start : 0;
+        }
+    }
+
+    return region;
+}
+
+// Fault in every page of the range now instead of during a launch
+static void populateRange(uintptr_t start, size_t size)
+{
+#ifdef MADV_POPULATE_READ
+    if (madvise(reinterpret_cast<void *>(start), size, MADV_POPULATE_READ) == 0)
+        return;
+#endif
+
+    // Kernels before 5.14: touch the pages one by one
+    const size_t pageSize = getpagesize();
+    for (size_t offset = 0; offset < size; offset += pageSize)
+        (void)*reinterpret_cast<const volatile char *>(start + offset);
+}
+
+// Return true if only this user can have written the file of st
+static bool isPrivate(const struct stat & st)
+{
+    return st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+// Write a snapshot of region to path, replacing it atomically
+static bool writeRelroSnapshot(const string & path, const RelroRegion & region, const struct stat & st)
+{
+    std::ostringstream tmpPath;
+    tmpPath << path << '.' << getpid();
+
+    int fd = open(tmpPath.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+        return false;
+
+    RelroHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = RELRO_MAGIC;
+    header.headerSize = sizeof(header);
+    header.mtime = st.st_mtime;
+    header.start = region.start;
+    header.size = region.size;
+
+    const bool ok =
+        pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+        pwrite(fd, reinterpret_cast<const void *>(region.start), region.size, getpagesize()) ==
+            static_cast<ssize_t>(region.size);
+
+    close(fd);
+
+    if (!ok || rename(tmpPath.str().c_str(), path.c_str()) == -1)
+    {
+        unlink(tmpPath.str().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Map the snapshot at path over region if it has exactly the same contents
+static bool mapRelroSnapshot(const string & path, const RelroRegion & region, const struct stat & st)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd == -1)
+        return false;
+
+    // The snapshot replaces pointers the library relies on, so it must
+    // come from this user and nobody else may have modified it
+    struct stat snapshotSt;
+    if (fstat(fd, &snapshotSt) == -1 || !S_ISREG(snapshotSt.st_mode) || !isPrivate(snapshotSt))
+    {
+        LOGGER_WARNING("Preloader: ignoring RELRO snapshot %s not private to this user", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    RelroHeader header;
+    bool ok = pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+        header.magic == RELRO_MAGIC && header.headerSize == sizeof(header) &&
+        header.mtime == static_cast<uint64_t>(st.st_mtime) &&
+        header.start == region.start && header.size == region.size;
+
+    if (ok)
+    {
+        void * snapshot = mmap(NULL, region.size, PROT_READ, MAP_PRIVATE, fd, getpagesize());
+        ok = snapshot != MAP_FAILED &&
+            memcmp(snapshot, reinterpret_cast<const void *>(region.start), region.size) == 0;
+
+        if (snapshot != MAP_FAILED)
+            munmap(snapshot, region.size);
+    }
+
+    if (ok)
+        ok = mmap(reinterpret_cast<void *>(region.start), region.size, PROT_READ,
+                  MAP_PRIVATE | MAP_FIXED, fd, getpagesize()) != MAP_FAILED;
+
+    close(fd);
+    return ok;
+}
+
+// Default number of prefetch threads, unless set in the configuration
+static unsigned int defaultThreadCount()
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus < 1 ? 1 : cpus > 4 ? 4 : cpus;
+}
+
+// Read the whole file at path into the page cache
+static void prefetchFile(const char * path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        readahead(fd, 0, st.st_size);
+
+    close(fd);
+}
+
+// Return the size of transparent huge pages, 0 if they are disabled
+static size_t hugePageSize()
+{
+    std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/enabled");
+    string mode;
+    if (!std::getline(enabled, mode) || mode.find("[never]") != string::npos)
+        return 0;
+
+    std::ifstream pmdSize("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+    size_t size = 0;
+    if (!(pmdSize >> size))
+        size = 2 * 1024 * 1024;
+
+    return size;
+}
+
+// Replace the range with a copy in anonymous huge pages. The range
+// must be aligned to huge pages and must not be written to meanwhile.
+static bool copyToHugePages(uintptr_t start, size_t size, size_t hugeSize, int prot)
+{
+    // Over-allocate to find an aligned address for the copy
+    char * area = static_cast<char *>(mmap(NULL, size + hugeSize, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (area == MAP_FAILED)
+        return false;
+
+    const uintptr_t copy = (reinterpret_cast<uintptr_t>(area) + hugeSize - 1) & ~(hugeSize - 1);
+    if (copy != reinterpret_cast<uintptr_t>(area))
+        munmap(area, copy - reinterpret_cast<uintptr_t>(area));
+    munmap(reinterpret_cast<void *>(copy + size), reinterpret_cast<uintptr_t>(area) + hugeSize - copy);
+
+    madvise(reinterpret_cast<void *>(copy), size, MADV_HUGEPAGE);
+    memcpy(reinterpret_cast<void *>(copy), reinterpret_cast<const void *>(start), size);
+
+    if (mprotect(reinterpret_cast<void *>(copy), size, prot) == -1 ||
+        mremap(reinterpret_cast<void *>(copy), size, size, MREMAP_MAYMOVE | MREMAP_FIXED,
+               reinterpret_cast<void *>(start)) == MAP_FAILED)
+    {
+        munmap(reinterpret_cast<void *>(copy), size);
+        return false;
+    }
+
+    return true;
+}
+
+Preloader::Entry::Entry() :
+    kind(Library),
+    shareRelro(false),
+    willNeed(false),
+    populate(false),
+    lock(false),
+    hugePages(NoHugePages),
+    tier(0),
+    handle(NULL)
+{}
+
+Preloader::Preloader(const string & boosterType) :
+    m_boosterType(boosterType),
+    m_threadCount(defaultThreadCount()),
+    m_mlockBudget(0),
+    m_hugePageSize(hugePageSize()),
+    m_nextPrefetch(0),
+    m_prefetchEnd(0),
+    m_nextEntry(0),
+    m_efficiencyCores(false),
+    m_idleUpgrade(false)
+{
+    // Snapshots are shared only in the private runtime directory,
+    // anyone could plant them in the /tmp fallback of the sockets
+    const char * runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir)
+        m_relroDir = string(runtimeDir) + "/mapplauncherd/relro";
+
+    pthread_mutex_init(&m_prefetchMutex, NULL);
+}
+
+Preloader::~Preloader()
+{
+    joinPrefetch();
+    pthread_mutex_destroy(&m_prefetchMutex);
+}
+
+bool Preloader::readConfig()
+{
+    const string path = string(BOOSTER_PRELOAD_DIR) + "/" + m_boosterType + ".conf";
+    std::ifstream config(path.c_str());
+    if (!config)
+        return false;
+
+    string line;
+    for (int lineNumber = 1; std::getline(config, line); lineNumber++)
+    {
+        Entry entry;
+        if (!parseLine(line, entry))
+            LOGGER_WARNING("Preloader: %s:%d: malformed line", path.c_str(), lineNumber);
+        else if (!entry.path.empty())
+            m_entries.push_back(entry);
+    }
+
+    // Keep the configured order within a tier
+    std::stable_sort(m_entries.begin(), m_entries.end(), lowerTier);
+
+    LOGGER_DEBUG("Preloader: %u entries in %s", static_cast<unsigned int>(m_entries.size()), path.c_str());
+    return true;
+}
+
+bool Preloader::parseLine(const string & line, Entry & entry)
+{
+    std::istringstream fields(line);
+    string kind;
+    if (!(fields >> kind) || kind[0] == '#')
+        return true;
+
+    if (kind == "threads")
+    {
+        unsigned int count;
+        if (!(fields >> count) || count > MAX_THREADS)
+            return false;
+
+        m_threadCount = count;
+        return true;
+    }
+
+    if (kind == "mlock-budget")
+    {
+        unsigned long kilobytes;
+        if (!(fields >> kilobytes))
+            return false;
+
+        m_mlockBudget = kilobytes * 1024;
+        return true;
+    }
+
+    if (kind == "efficiency-cores")
+    {
+        m_efficiencyCores = true;
+        return true;
+    }
+
+    if (kind == "idle-upgrade")
+    {
+        m_idleUpgrade = true;
+        return true;
+    }
+
+    if (kind == "data")
+        entry.kind = Entry::Data;
+    else if (kind != "library")
+        return false;
+
+    if (!(fields >> entry.path) || entry.path[0] != '/')
+        return false;
+
+    string option;
+    while (fields >> option)
+    {
+        if (option.compare(0, 5, "tier=") == 0)
+        {
+            char * end = NULL;
+            entry.tier = strtoul(option.c_str() + 5, &end, 10);
+            if (end == option.c_str() + 5 || *end)
+                return false;
+        }
+        else if (entry.kind != Entry::Library)
+            return false;
+        else if (option == "relro")
+            entry.shareRelro = true;
+        else if (option == "willneed")
+            entry.willNeed = true;
+        else if (option == "populate")
+            entry.populate = true;
+        else if (option == "mlock")
+            entry.lock = true;
+        else if (option == "hugepage")
+            entry.hugePages = Entry::FileOrCopyHugePages;
+        else if (option == "hugepage=file")
+            entry.hugePages = Entry::FileHugePages;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+bool Preloader::lowerTier(const Entry & a, const Entry & b)
+{
+    return a.tier < b.tier;
+}
+
+void Preloader::preload()
+{
+    m_prefetchEnd = 0;
+    while (m_prefetchEnd < m_entries.size() && m_entries[m_prefetchEnd].tier == 0)
+        m_prefetchEnd++;
+
+    // Loading the libraries is serialized by the dynamic linker anyway,
+    // but reading them from the disk can go on in parallel ahead of it
+    startPrefetch();
+
+    // Without prefetch threads nobody else reads the data files
+    const bool prefetching = !m_threads.empty();
+    for (; m_nextEntry < m_prefetchEnd; m_nextEntry++)
+    {
+        if (!prefetching || m_entries[m_nextEntry].kind == Entry::Library)
+            preloadEntry(m_entries[m_nextEntry]);
+    }
+
+    // The booster must be single-threaded when it forks
+    joinPrefetch();
+}
+
+bool Preloader::upgrade(int fd)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    for (; m_nextEntry < m_entries.size(); m_nextEntry++)
+    {
+        // Launch with what has been preloaded so far rather than wait
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) != 0)
+        {
+            LOGGER_DEBUG("Preloader: invoker waiting, stopping at tier %u", m_entries[m_nextEntry].tier);
+            return false;
+        }
+
+        if (!m_nextEntry || m_entries[m_nextEntry - 1].tier != m_entries[m_nextEntry].tier)
+            LOGGER_DEBUG("Preloader: preloading tier %u", m_entries[m_nextEntry].tier);
+
+        preloadEntry(m_entries[m_nextEntry]);
+    }
+
+    return true;
+}
+
+bool Preloader::upgradable() const
+{
+    return m_nextEntry < m_entries.size();
+}
+
+void Preloader::release()
+{
+    joinPrefetch();
+
+    // Swapping with empty ones frees the storage, clear() would keep it
+    vector<Entry>().swap(m_entries);
+    vector<pthread_t>().swap(m_threads);
+    string().swap(m_boosterType);
+    string().swap(m_relroDir);
+
+    m_nextPrefetch = 0;
+    m_prefetchEnd = 0;
+    m_nextEntry = 0;
+}
+
+bool Preloader::efficiencyCores() const
+{
+    return m_efficiencyCores;
+}
+
+bool Preloader::idleUpgrade() const
+{
+    return m_idleUpgrade;
+}
+
+void Preloader::preloadEntry(Entry & entry)
+{
+    if (entry.kind == Entry::Library)
+        loadLibrary(entry);
+    else
+        prefetchFile(entry.path.c_str());
+}
+
+void Preloader::startPrefetch()
+{
+    m_nextPrefetch = 0;
+
+    const unsigned int count = std::min(m_threadCount, m_prefetchEnd);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        pthread_t thread;
+        const int error = pthread_create(&thread, NULL, prefetchThread, this);
+        if (error)
+        {
+            LOGGER_WARNING("Preloader: can't create prefetch thread: %s", strerror(error));
+            break;
+        }
+
+        m_threads.push_back(thread);
+    }
+
+    LOGGER_DEBUG("Preloader: prefetching in %u threads", static_cast<unsigned int>(m_threads.size()));
+}
+
+void Preloader::joinPrefetch()
+{
+    for (unsigned int i = 0; i < m_threads.size(); i++)
+        pthread_join(m_threads[i], NULL);
+
+    m_threads.clear();
+}
+
+void * Preloader::prefetchThread(void * preloader)
+{
+    Preloader * self = static_cast<Preloader *>(preloader);
+    while (const char * path = self->nextPrefetch())
+        prefetchFile(path);
+
+    return NULL;
+}
+
+const char * Preloader::nextPrefetch()
+{
+    pthread_mutex_lock(&m_prefetchMutex);
+    const char * path = m_nextPrefetch < m_prefetchEnd ? m_entries[m_nextPrefetch++].path.c_str() : NULL;
+    pthread_mutex_unlock(&m_prefetchMutex);
+    return path;
+}
+
+void Preloader::loadLibrary(Entry & entry)
+{
+    // Resolve everything now so that the relocations are done before
+    // the RELRO region is shared and before any application is launched
+    entry.handle = dlopen(entry.path.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if (!entry.handle)
+    {
+        LOGGER_WARNING("Preloader: can't preload %s: %s", entry.path.c_str(), dlerror());
+        return;
+    }
+
+    struct dl_phdr_info info;
+    if (!findLoadedObject(entry.handle, info))
+        return;
+
+    if (entry.shareRelro)
+        shareRelro(entry, info);
+
+    // Before the page options, which then apply to the new mapping
+    if (entry.hugePages != Entry::NoHugePages)
+        remapToHugePages(entry, info);
+
+    if (entry.willNeed || entry.populate || entry.lock)
+        touchPages(entry, info);
+}
+
+void Preloader::remapToHugePages(const Entry & entry, const struct dl_phdr_info & info)
+{
+    if (!m_hugePageSize)
+    {
+        LOGGER_DEBUG("Preloader: transparent huge pages are disabled");
+        return;
+    }
+
+    for (int i = 0; i < info.dlpi_phnum; i++)
+    {
+        const ElfW(Phdr) & phdr = info.dlpi_phdr[i];
+        if (phdr.p_type != PT_LOAD || !(phdr.p_flags & PF_X))
+            continue;
+
+        // Only the part of the text covering whole huge pages can use them
+        const uintptr_t begin = info.dlpi_addr + phdr.p_vaddr;
+        const uintptr_t start = (begin + m_hugePageSize - 1) & ~(m_hugePageSize - 1);
+        const uintptr_t end = (begin + phdr.p_memsz) & ~(m_hugePageSize - 1);
+        if (end <= start)
+        {
+            LOGGER_DEBUG("Preloader: text of %s is smaller than a huge page", entry.path.c_str());
+            continue;
+        }
+
+        // File-backed huge pages stay shared with other processes. Without
+        // MADV_COLLAPSE the kernel may still collapse them later on.
+        void * text = reinterpret_cast<void *>(start);
+        madvise(text, end - start, MADV_HUGEPAGE);
+        if (madvise(text, end - start, MADV_COLLAPSE) == 0)
+        {
+            LOGGER_DEBUG("Preloader: %u kB of %s in file huge pages",
+                         static_cast<unsigned int>((end - start) / 1024), entry.path.c_str());
+        }
+        else if (entry.hugePages == Entry::FileOrCopyHugePages)
+        {
+            if (copyToHugePages(start, end - start, m_hugePageSize, PROT_READ | PROT_EXEC))
+                LOGGER_DEBUG("Preloader: %u kB of %s copied to huge pages",
+                             static_cast<unsigned int>((end - start) / 1024), entry.path.c_str());
+            else
+                LOGGER_WARNING("Preloader: can't copy %s to huge pages: %s",
+                               entry.path.c_str(), strerror(errno));
+        }
+    }
+}
+
+void Preloader::touchPages(const Entry & entry, const struct dl_phdr_info & info)
+{
+    const uintptr_t pageSize = getpagesize();
+    for (int i = 0; i < info.dlpi_phnum; i++)
+    {
+        const ElfW(Phdr) & phdr = info.dlpi_phdr[i];
+        if (phdr.p_type != PT_LOAD)
+            continue;
+
+        const uintptr_t start = (info.dlpi_addr + phdr.p_vaddr) & ~(pageSize - 1);
+        const size_t size = info.dlpi_addr + phdr.p_vaddr + phdr.p_memsz - start;
+
+        // Ask the kernel to read ahead, then fault the pages in now
+        if (entry.willNeed)
+            madvise(reinterpret_cast<void *>(start), size, MADV_WILLNEED);
+
+        if (entry.populate)
+            populateRange(start, size);
+
+        // Only text is locked: it is what the launch waits for on a page fault
+        if (entry.lock && (phdr.p_flags & PF_X) && m_mlockBudget)
+        {
+            const size_t lockSize = size < m_mlockBudget ? size : m_mlockBudget & ~(pageSize - 1);
+            if (lockSize && mlock(reinterpret_cast<void *>(start), lockSize) == 0)
+            {
+                m_mlockBudget -= lockSize;
+                LOGGER_DEBUG("Preloader: locked %u kB of %s",
+                             static_cast<unsigned int>(lockSize / 1024), entry.path.c_str());
+            }
+            else if (lockSize)
+            {
+                LOGGER_WARNING("Preloader: can't lock %s: %s", entry.path.c_str(), strerror(errno));
+            }
+        }
+    }
+}
+
+void Preloader::shareRelro(const Entry & entry, const struct dl_phdr_info & info)
+{
+    if (m_relroDir.empty())
+    {
+        LOGGER_DEBUG("Preloader: no runtime directory to share RELRO of %s in", entry.path.c_str());
+        return;
+    }
+
+    const RelroRegion region = relroRegion(info);
+
+    struct stat st;
+    if (!region.size || stat(info.dlpi_name, &st) == -1)
+    {
+        LOGGER_DEBUG("Preloader: no RELRO region to share in %s", entry.path.c_str());
+        return;
+    }
+
+    if (mkdir(m_relroDir.c_str(), S_IRWXU) == -1 && errno != EEXIST)
+    {
+        LOGGER_WARNING("Preloader: can't create %s: %s", m_relroDir.c_str(), strerror(errno));
+        return;
+    }
+
+    struct stat dirSt;
+    if (lstat(m_relroDir.c_str(), &dirSt) == -1 || !S_ISDIR(dirSt.st_mode) || !isPrivate(dirSt))
+    {
+        LOGGER_WARNING("Preloader: not sharing RELRO, %s is not private to this user", m_relroDir.c_str());
+        return;
+    }
+
+    // Boosters of the same type load the library at the same address
+    // as they are forked from the same process
+    std::ostringstream path;
+    path << m_relroDir << '/' << m_boosterType << '-' << st.st_dev << '-' << st.st_ino;
+
+    if (mapRelroSnapshot(path.str(), region, st))
+    {
+        LOGGER_DEBUG("Preloader: sharing %u bytes of RELRO of %s",
+                     static_cast<unsigned int>(region.size), entry.path.c_str());
+        return;
+    }
+
+    // No usable snapshot: write one from this process and share it from now on
+    if (!writeRelroSnapshot(path.str(), region, st) || !mapRelroSnapshot(path.str(), region, st))
+        LOGGER_WARNING("Preloader: can't share RELRO of %s: %s", entry.path.c_str(), strerror(errno));
+    else
+        LOGGER_DEBUG("Preloader: wrote RELRO snapshot of %s", entry.path.c_str());
+}
@@ -0,0 +1,246 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef PRELOADER_H
+#define PRELOADER_H
+
+#include <link.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+/*!
+ * \class Preloader
+ * \brief Preloads the files listed in the preload configuration of a booster type.
+ *
+ * The configuration is read from BOOSTER_PRELOAD_DIR/<type>.conf. Each
+ * line names a file to preload followed by its options, or sets the
+ * number of prefetch threads and the CPU policy of the booster:
+ *
+ * \code
+ * # comment
+ * threads 4
+ * mlock-budget 8192
+ * efficiency-cores
+ * idle-upgrade
+ * library /usr/lib/libQt5Core.so.5 relro populate mlock hugepage
+ * data /usr/share/themes/default/meegotouch/constants.ini
+ * library /usr/lib/libQt5Qml.so.5 tier=1
+ * \endcode
+ *
+ * Entries are preloaded in tiers given with the option tier=N, 0 by
+ * default. Tier 0 is preloaded before the booster is ready to launch.
+ * The higher tiers are preloaded in order after that, but only until an
+ * invoker connects, so that launches don't wait for them.
+ *
+ * The files of tier 0 are read into the page cache by a few threads
+ * while the libraries are loaded with dlopen() one by one. The threads
+ * are joined before preload() returns, so the booster is single-threaded
+ * again when it forks or execs. With the option "relro" the
+ * relocated RELRO region of the library is written to a snapshot file
+ * in the runtime directory once, and later boosters map the snapshot
+ * over their own copy so that the pages are shared instead of private.
+ * Snapshots are only shared in XDG_RUNTIME_DIR and only if they and
+ * their directory belong to the user and nobody else can write them.
+ */
+class Preloader
+{
+public:
+
+    //! Constructor
+    explicit Preloader(const string & boosterType);
+
+    //! Destructor
+    ~Preloader();
+
+    /*! \brief Read the preload configuration of the booster type.
+     *  \return false if there is no configuration.
+     */
+    bool readConfig();
+
+    //! Preload the files of tier 0
+    void preload();
+
+    /*! \brief Preload the files of the higher tiers one by one until
+     *  there is input on fd.
+     *  \return true if all files were preloaded.
+     */
+    bool upgrade(int fd);
+
+    //! Return true if files of higher tiers are still to be preloaded
+    bool upgradable() const;
+
+    /*! \brief Free the configuration once preloading is over, so that it
+     *  doesn't stay allocated while the booster waits. The loaded libraries
+     *  stay loaded.
+     */
+    void release();
+
+    //! Return true if the booster should preload on the efficiency cores
+    bool efficiencyCores() const;
+
+    //! Return true if the higher tiers should be preloaded with SCHED_IDLE
+    bool idleUpgrade() const;
+
+private:
+
+    //! Disable copy-constructor
+    Preloader(const Preloader & r);
+
+    //! Disable assignment operator
+    Preloader & operator= (const Preloader & r);
+
+    //! Maximum number of prefetch threads
+    static const unsigned int MAX_THREADS = 16;
+
+    //! A file to preload
+    struct Entry
+    {
+        Entry();
+
+        //! Kind of the entry
+        enum Kind
+        {
+            //! Shared library loaded with dlopen()
+            Library,
+
+            //! File that is only read into the page cache
+            Data
+        };
+
+        Kind kind;
+
+        //! Path of the file
+        string path;
+
+        //! Share the RELRO region of the library
+        bool shareRelro;
+
+        //! Advise the kernel to read the library ahead (MADV_WILLNEED)
+        bool willNeed;
+
+        //! Fault in all pages of the library
+        bool populate;
+
+        //! Lock the text of the library in memory, within the budget
+        bool lock;
+
+        //! Use of huge pages for the text of the library
+        enum HugePages
+        {
+            //! Normal pages
+            NoHugePages,
+
+            //! File-backed huge pages where the kernel supports them
+            FileHugePages,
+
+            //! File-backed huge pages, or else a copy in anonymous huge pages
+            FileOrCopyHugePages
+        };
+
+        HugePages hugePages;
+
+        //! Preload tier, lower tiers are preloaded first
+        unsigned int tier;
+
+        //! Handle returned by dlopen()
+        void * handle;
+    };
+
+    //! Order entries by their tier
+    static bool lowerTier(const Entry & a, const Entry & b);
+
+    //! Preload the file of entry
+    void preloadEntry(Entry & entry);
+
+    //! Parse one line of the configuration, return false if it is malformed
+    bool parseLine(const string & line, Entry & entry);
+
+    //! Load the library of entry
+    void loadLibrary(Entry & entry);
+
+    //! Start threads reading the files of all entries into the page cache
+    void startPrefetch();
+
+    //! Wait for the prefetch threads to finish
+    void joinPrefetch();
+
+    //! Body of the prefetch threads
+    static void * prefetchThread(void * preloader);
+
+    //! Return the path of the next file to prefetch, NULL when there are no more
+    const char * nextPrefetch();
+
+    //! Replace the RELRO region of a loaded library with the shared snapshot
+    void shareRelro(const Entry & entry, const struct dl_phdr_info & info);
+
+    //! Map the text of the loaded library of entry to huge pages
+    void remapToHugePages(const Entry & entry, const struct dl_phdr_info & info);
+
+    //! Apply the page policies of entry to the segments of the loaded library
+    void touchPages(const Entry & entry, const struct dl_phdr_info & info);
+
+    //! Booster type whose configuration is used
+    string m_boosterType;
+
+    //! Directory of the RELRO snapshots, empty if RELRO isn't shared
+    string m_relroDir;
+
+    //! Files to preload, in the configured order
+    vector<Entry> m_entries;
+
+    //! Number of prefetch threads to use
+    unsigned int m_threadCount;
+
+    //! Bytes that may still be locked with mlock()
+    size_t m_mlockBudget;
+
+    //! Size of transparent huge pages, 0 if disabled
+    size_t m_hugePageSize;
+
+    //! Running prefetch threads
+    vector<pthread_t> m_threads;
+
+    //! Protects m_nextPrefetch
+    pthread_mutex_t m_prefetchMutex;
+
+    //! Index of the next entry to prefetch
+    unsigned int m_nextPrefetch;
+
+    //! Index of the first entry not to prefetch
+    unsigned int m_prefetchEnd;
+
+    //! Index of the next entry to preload
+    unsigned int m_nextEntry;
+
+    //! Set by the efficiency-cores directive
+    bool m_efficiencyCores;
+
+    //! Set by the idle-upgrade directive
+    bool m_idleUpgrade;
+};
+
+#endif // PRELOADER_H
@@ -0,0 +1,418 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "requestreader.h"
+#include "launchbatch.h"
+#include "connection.h"
+#include "logger.h"
+
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+// Milliseconds of CLOCK_MONOTONIC
+static long long monotonicMillis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+RequestReader::RequestReader(int fd, int id, const string & boosterType) :
+    m_fd(fd),
+    m_id(id),
+    m_boosterType(boosterType),
+    m_accepted(monotonicMillis()),
+    m_magic(0),
+    m_instancePid(0),
+    m_strings(0),
+    m_step(Magic),
+    m_received(0),
+    m_batchCount(0)
+{
+    m_batchIO[0] = -1;
+    m_batchIO[1] = -1;
+    m_batchIO[2] = -1;
+
+    expect(Magic, sizeof(uint32_t));
+}
+
+RequestReader::~RequestReader()
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (m_batchIO[i] != -1)
+            close(m_batchIO[i]);
+    }
+
+    if (m_fd != -1)
+        close(m_fd);
+}
+
+RequestReader::Status RequestReader::read()
+{
+    while (true)
+    {
+        if (m_received < m_piece.size())
+        {
+            if (!receive())
+                return Failed;
+
+            if (m_received < m_piece.size())
+                return Reading;
+        }
+
+        const Status status = handlePiece();
+        if (status != Reading)
+            return status;
+    }
+}
+
+bool RequestReader::expired() const
+{
+    return monotonicMillis() - m_accepted > TIMEOUT_MS;
+}
+
+int RequestReader::fd() const
+{
+    return m_fd;
+}
+
+int RequestReader::id() const
+{
+    return m_id;
+}
+
+const string & RequestReader::boosterType() const
+{
+    return m_boosterType;
+}
+
+uint32_t RequestReader::magic() const
+{
+    return m_magic;
+}
+
+const string & RequestReader::header() const
+{
+    return m_header;
+}
+
+const string & RequestReader::appName() const
+{
+    return m_appName;
+}
+
+void RequestReader::skipBody(pid_t instancePid)
+{
+    m_instancePid = instancePid;
+    expect(BodyAction, sizeof(uint32_t));
+}
+
+pid_t RequestReader::instancePid() const
+{
+    return m_instancePid;
+}
+
+int RequestReader::releaseFd()
+{
+    const int fd = m_fd;
+    m_fd = -1;
+    return fd;
+}
+
+LaunchBatch * RequestReader::takeBatch()
+{
+    LaunchBatch * batch = new LaunchBatch(releaseFd(), m_magic, m_batchIO, m_batchEntries);
+
+    m_batchIO[0] = -1;
+    m_batchIO[1] = -1;
+    m_batchIO[2] = -1;
+    m_batchEntries.clear();
+
+    return batch;
+}
+
+void RequestReader::expect(Step step, size_t size)
+{
+    m_step = step;
+    m_piece.assign(size, '\0');
+    m_received = 0;
+}
+
+bool RequestReader::receive()
+{
+    struct iovec iov;
+    iov.iov_base = &m_piece[m_received];
+    iov.iov_len  = m_piece.size() - m_received;
+
+    // Descriptors are kept only from the I/O byte of a batch, any others are closed
+    char buf[CMSG_SPACE(sizeof(m_batchIO))];
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = buf;
+    msg.msg_controllen = sizeof(buf);
+
+    const ssize_t ret = recvmsg(m_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (ret < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return true;
+
+        LOGGER_ERROR("RequestReader: can't read request %d: %s", m_id, strerror(errno));
+        return false;
+    }
+
+    if (ret == 0)
+    {
+        LOGGER_ERROR("RequestReader: invoker closed request %d", m_id);
+        return false;
+    }
+
+    m_received += ret;
+
+    for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        int fds[sizeof(buf) / sizeof(int)];
+        const unsigned int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(fds, CMSG_DATA(cmsg), count * sizeof(int));
+
+        if (m_step == BatchIO && count == 3 && m_batchIO[0] == -1)
+        {
+            memcpy(m_batchIO, fds, sizeof(m_batchIO));
+        }
+        else
+        {
+            for (unsigned int i = 0; i < count; i++)
+                close(fds[i]);
+        }
+    }
+
+    return true;
+}
+
+uint32_t RequestReader::word(unsigned int index) const
+{
+    uint32_t value = 0;
+    memcpy(&value, m_piece.data() + index * sizeof(value), sizeof(value));
+    return value;
+}
+
+RequestReader::Status RequestReader::handlePiece()
+{
+    switch (m_step)
+    {
+    case Magic:
+        m_magic = word(0);
+        if ((m_magic & INVOKER_MSG_MASK) == INVOKER_MSG_MAGIC &&
+            (m_magic & INVOKER_MSG_MAGIC_OPTION_BATCH))
+        {
+            if ((m_magic & INVOKER_MSG_MAGIC_VERSION_MASK) != INVOKER_MSG_MAGIC_VERSION)
+            {
+                LOGGER_ERROR("RequestReader: batch with bad magic (%08x)", m_magic);
+                return Failed;
+            }
+
+            expect(BatchHeader, 2 * sizeof(uint32_t));
+            return Reading;
+        }
+
+        m_header = m_piece;
+        if ((m_magic & INVOKER_MSG_MASK) == INVOKER_MSG_MAGIC &&
+            (m_magic & INVOKER_MSG_MAGIC_OPTION_SINGLE_INSTANCE))
+        {
+            expect(Name, 2 * sizeof(uint32_t));
+            return Reading;
+        }
+
+        // Everything else is checked by the booster
+        return HeaderRead;
+
+    case Name:
+        if (word(0) != INVOKER_MSG_NAME || word(1) == 0 || word(1) > INVOKER_STR_LEN_MAX)
+        {
+            LOGGER_ERROR("RequestReader: invalid single-instance request %d", m_id);
+            return Failed;
+        }
+
+        m_header += m_piece;
+        expect(NameData, word(1));
+        return Reading;
+
+    case NameData:
+        m_header += m_piece;
+        m_appName.assign(m_piece.data(), strnlen(m_piece.data(), m_piece.size()));
+        if (m_appName.empty())
+        {
+            LOGGER_ERROR("RequestReader: no name in single-instance request %d", m_id);
+            return Failed;
+        }
+        return HeaderRead;
+
+    case BatchHeader:
+        m_batchCount = word(1);
+        if (word(0) != INVOKER_MSG_BATCH || m_batchCount == 0 ||
+            m_batchCount > LaunchBatch::MAX_ENTRIES)
+        {
+            LOGGER_ERROR("RequestReader: invalid batch header (%08x, %u entries)",
+                         word(0), m_batchCount);
+            return Failed;
+        }
+
+        expect(BatchAction, sizeof(uint32_t));
+        return Reading;
+
+    case BatchAction:
+        switch (word(0))
+        {
+        case INVOKER_MSG_END:
+            if (m_batchEntries.size() != m_batchCount)
+            {
+                LOGGER_ERROR("RequestReader: expected %u batch entries, got %u", m_batchCount,
+                             static_cast<unsigned int>(m_batchEntries.size()));
+                return Failed;
+            }
+            return BatchRead;
+
+        case INVOKER_MSG_IO:
+            expect(BatchIO, 1);
+            return Reading;
+
+        case INVOKER_MSG_BATCH_ENTRY:
+            expect(BatchEntrySize, sizeof(uint32_t));
+            return Reading;
+
+        default:
+            LOGGER_ERROR("RequestReader: received invalid batch action (%08x)", word(0));
+            return Failed;
+        }
+
+    case BatchIO:
+        if (m_batchIO[0] == -1)
+        {
+            LOGGER_ERROR("RequestReader: no I/O descriptors received for batch %d", m_id);
+            return Failed;
+        }
+
+        expect(BatchAction, sizeof(uint32_t));
+        return Reading;
+
+    case BatchEntrySize:
+        if (word(0) < sizeof(uint32_t) || word(0) > LaunchBatch::MAX_ENTRY_SIZE ||
+            m_batchEntries.size() >= m_batchCount)
+        {
+            LOGGER_ERROR("RequestReader: invalid batch entry of %u bytes", word(0));
+            return Failed;
+        }
+
+        expect(BatchEntry, word(0));
+        return Reading;
+
+    case BatchEntry:
+        if (word(0) != INVOKER_MSG_NAME)
+        {
+            LOGGER_ERROR("RequestReader: batch entry %u doesn't start with a name",
+                         static_cast<unsigned int>(m_batchEntries.size()));
+            return Failed;
+        }
+
+        m_batchEntries.push_back(m_piece);
+        expect(BatchAction, sizeof(uint32_t));
+        return Reading;
+
+    case BodyAction:
+    {
+        // The booster parses requests with the same table
+        uint32_t words = 0;
+        switch (Connection::payloadKind(word(0), words))
+        {
+        case Connection::WordsPayload:
+            expect(BodyWords, words * sizeof(uint32_t));
+            return Reading;
+
+        case Connection::StringPayload:
+            m_strings = 1;
+            expect(BodyStringSize, sizeof(uint32_t));
+            return Reading;
+
+        case Connection::StringsPayload:
+            expect(BodyStringCount, sizeof(uint32_t));
+            return Reading;
+
+        case Connection::IOPayload:
+            expect(BodyIO, 1);
+            return Reading;
+
+        case Connection::EndPayload:
+            return BodySkipped;
+
+        default:
+            LOGGER_ERROR("RequestReader: received invalid action (%08x) in request %d", word(0), m_id);
+            return Failed;
+        }
+    }
+
+    case BodyStringCount:
+        m_strings = word(0);
+        if (m_strings > INVOKER_ARGS_MAX + INVOKER_ENV_MAX)
+        {
+            LOGGER_ERROR("RequestReader: too many strings (%u) in request %d", m_strings, m_id);
+            return Failed;
+        }
+
+        if (m_strings > 0)
+            expect(BodyStringSize, sizeof(uint32_t));
+        else
+            expect(BodyAction, sizeof(uint32_t));
+        return Reading;
+
+    case BodyStringSize:
+        if (word(0) > INVOKER_STR_LEN_MAX)
+        {
+            LOGGER_ERROR("RequestReader: string of %u bytes in request %d", word(0), m_id);
+            return Failed;
+        }
+
+        m_strings--;
+        expect(BodyString, word(0));
+        return Reading;
+
+    case BodyString:
+        if (m_strings > 0)
+            expect(BodyStringSize, sizeof(uint32_t));
+        else
+            expect(BodyAction, sizeof(uint32_t));
+        return Reading;
+
+    case BodyWords:
+    case BodyIO:
+        expect(BodyAction, sizeof(uint32_t));
+        return Reading;
+    }
+
+    return Failed;
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef REQUESTREADER_H
+#define REQUESTREADER_H
+
+#include "protocol.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+class LaunchBatch;
+
+/*!
+ * \class RequestReader
+ * \brief Reads the part of an invoker request the daemon needs without blocking.
+ *
+ * The daemon reads the magic number of every accepted invoker connection
+ * before it queues the connection for a booster, the application name of
+ * single instance launches and batch requests as a whole. Requests for an
+ * already running single instance application are read to the end and
+ * discarded. The connection is non-blocking: read() consumes whatever has
+ * arrived and is called again when select() reports more, so a slow or
+ * stalled invoker never holds up the daemon. Each piece of the request is
+ * read with its exact size, nothing that belongs to the booster is consumed.
+ */
+class RequestReader
+{
+public:
+
+    //! Result of read()
+    enum Status
+    {
+        Reading,    //!< More data is needed
+        Failed,     //!< The request is malformed or the invoker went away
+        HeaderRead, //!< The connection can be handed over to a booster
+        BatchRead,  //!< A complete batch request has been read
+        BodySkipped //!< The request has been read to the end after skipBody()
+    };
+
+    //! Milliseconds an invoker may take to send what the daemon reads
+    static const int TIMEOUT_MS = 2000;
+
+    /*! \brief Constructor.
+     *  \param fd Accepted non-blocking invoker connection. RequestReader takes the ownership.
+     *  \param id Number of the accepted connection, used in the event journal.
+     *  \param boosterType Type of the booster the connection was accepted for.
+     */
+    RequestReader(int fd, int id, const string & boosterType);
+
+    //! Destructor, closes the connection unless it has been released
+    ~RequestReader();
+
+    //! Read what has arrived and return how far the request is
+    Status read();
+
+    //! Return true if the invoker has taken longer than TIMEOUT_MS
+    bool expired() const;
+
+    //! Return the connection, -1 if it has been released
+    int fd() const;
+
+    //! Return the number of the connection
+    int id() const;
+
+    //! Return the type of the booster the connection was accepted for
+    const string & boosterType() const;
+
+    //! Return the magic number, valid once read() has returned HeaderRead
+    uint32_t magic() const;
+
+    //! Return the beginning of the request read so far, it goes to the booster
+    const string & header() const;
+
+    //! Return the application name of a single instance launch, empty for others
+    const string & appName() const;
+
+    /*! \brief Read the rest of the request and discard it, after HeaderRead.
+     *  \param instancePid Running instance the request is answered for.
+     */
+    void skipBody(pid_t instancePid);
+
+    //! Return the pid given to skipBody()
+    pid_t instancePid() const;
+
+    //! Give the ownership of the connection to the caller, after HeaderRead
+    int releaseFd();
+
+    //! Create the batch of a BatchRead request, the caller takes the ownership
+    LaunchBatch * takeBatch();
+
+private:
+
+    //! Disable copy-constructor
+    RequestReader(const RequestReader & r);
+
+    //! Disable assignment operator
+    RequestReader & operator= (const RequestReader & r);
+
+    //! Pieces of the request, each read with its exact size
+    enum Step
+    {
+        Magic,          //!< The magic number
+        Name,           //!< INVOKER_MSG_NAME and the length of the name
+        NameData,       //!< The name of a single instance application
+        BatchHeader,    //!< INVOKER_MSG_BATCH and the number of entries
+        BatchAction,    //!< The next message of a batch
+        BatchIO,        //!< The byte carrying the shared I/O descriptors
+        BatchEntrySize, //!< The size of the next entry
+        BatchEntry,     //!< The messages of an application
+        BodyAction,     //!< The next message of a skipped request
+        BodyWords,      //!< Fixed size payload of a message
+        BodyStringCount,//!< Number of strings of a message
+        BodyStringSize, //!< Size of the next string
+        BodyString,     //!< A string
+        BodyIO          //!< The byte carrying I/O descriptors, which are closed
+    };
+
+    //! Start reading size bytes for step
+    void expect(Step step, size_t size);
+
+    //! Receive what has arrived of the current piece, false if the connection failed
+    bool receive();
+
+    //! Handle the current piece once it has been read completely
+    Status handlePiece();
+
+    //! Return the word at index of the current piece
+    uint32_t word(unsigned int index) const;
+
+    //! Connection to the invoker
+    int m_fd;
+
+    //! Number of the accepted connection
+    int m_id;
+
+    //! Type of the booster the connection was accepted for
+    string m_boosterType;
+
+    //! Monotonic time in milliseconds the connection was accepted
+    long long m_accepted;
+
+    //! Magic number of the request
+    uint32_t m_magic;
+
+    //! Beginning of the request handed over to the booster
+    string m_header;
+
+    //! Application name of a single instance launch
+    string m_appName;
+
+    //! Running instance a skipped request is answered for
+    pid_t m_instancePid;
+
+    //! Number of strings of the current message still to be skipped
+    uint32_t m_strings;
+
+    //! Piece being read
+    Step m_step;
+
+    //! Contents of the piece being read, sized to the piece
+    string m_piece;
+
+    //! Number of bytes of the piece read so far
+    size_t m_received;
+
+    //! Number of entries the batch announced
+    uint32_t m_batchCount;
+
+    //! I/O descriptors shared by the applications of the batch, -1 if not sent
+    int m_batchIO[3];
+
+    //! Messages of the applications of the batch
+    vector<string> m_batchEntries;
+};
+
+#endif // REQUESTREADER_H
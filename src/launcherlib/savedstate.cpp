@@ -0,0 +1,239 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "savedstate.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+//! Header of the serialized state
+struct SavedStateHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t  pid;
+    uint32_t size;
+};
+
+//! Header of a serialized record
+struct SavedStateRecord
+{
+    uint16_t tag;
+    uint16_t count;
+    uint32_t length;
+};
+
+//! Round size up to a multiple of four bytes
+static size_t padded(size_t size)
+{
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+//! Write all of data to fd
+static bool writeAll(int fd, const char * data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t ret = ::write(fd, data, size);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+
+        data += ret;
+        size -= ret;
+    }
+
+    return true;
+}
+
+//! Create an anonymous file that stays open over exec()
+static int createStateFd()
+{
+    int fd;
+
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "applauncherd-state", 0);
+    if (fd != -1 || errno != ENOSYS)
+        return fd;
+#endif
+
+    // Kernels without memfd: an unlinked file in the runtime directory
+    const char * runtimeDir = getenv("XDG_RUNTIME_DIR");
+    string path = string(runtimeDir && *runtimeDir ? runtimeDir : "/tmp") + "/applauncherd-state.XXXXXX";
+
+    vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+
+    fd = mkstemp(&name[0]);
+    if (fd != -1)
+        unlink(&name[0]);
+
+    return fd;
+}
+
+void SavedState::add(Tag tag, int32_t value)
+{
+    Record record;
+    record.tag = tag;
+    record.values.push_back(value);
+    m_records.push_back(record);
+}
+
+void SavedState::add(Tag tag, int32_t value1, int32_t value2)
+{
+    Record record;
+    record.tag = tag;
+    record.values.push_back(value1);
+    record.values.push_back(value2);
+    m_records.push_back(record);
+}
+
+void SavedState::add(Tag tag, int32_t value, const string & str)
+{
+    Record record;
+    record.tag = tag;
+    record.values.push_back(value);
+    record.str = str;
+    m_records.push_back(record);
+}
+
+void SavedState::add(Tag tag, int32_t value1, int32_t value2, const string & str)
+{
+    Record record;
+    record.tag = tag;
+    record.values.push_back(value1);
+    record.values.push_back(value2);
+    record.str = str;
+    m_records.push_back(record);
+}
+
+void SavedState::add(Tag tag, int32_t value1, int32_t value2, int32_t value3, const string & str)
+{
+    Record record;
+    record.tag = tag;
+    record.values.push_back(value1);
+    record.values.push_back(value2);
+    record.values.push_back(value3);
+    record.str = str;
+    m_records.push_back(record);
+}
+
+int SavedState::write() const
+{
+    string data;
+    for (RecordVect::const_iterator i = m_records.begin(); i != m_records.end(); i++)
+    {
+        SavedStateRecord record;
+        record.tag    = i->tag;
+        record.count  = i->values.size();
+        record.length = i->str.size();
+
+        data.append(reinterpret_cast<const char *>(&record), sizeof(record));
+        if (!i->values.empty())
+            data.append(reinterpret_cast<const char *>(&i->values[0]), i->values.size() * sizeof(int32_t));
+        data.append(i->str);
+        data.append(padded(i->str.size()) - i->str.size(), '\0');
+    }
+
+    SavedStateHeader header;
+    header.magic   = MAGIC;
+    header.version = VERSION;
+    header.pid     = getpid();
+    header.size    = data.size();
+
+    int fd = createStateFd();
+    if (fd == -1)
+        throw std::runtime_error(string("SavedState: Failed to create state: ") + strerror(errno));
+
+    if (!writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) ||
+        !writeAll(fd, data.data(), data.size()) ||
+        lseek(fd, 0, SEEK_SET) != 0)
+    {
+        const int error = errno;
+        close(fd);
+        throw std::runtime_error(string("SavedState: Failed to write state: ") + strerror(error));
+    }
+
+    return fd;
+}
+
+void SavedState::read(int fd)
+{
+    m_records.clear();
+
+    SavedStateHeader header;
+    string data;
+
+    bool ok = pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+              header.magic == MAGIC && header.version == VERSION;
+
+    if (ok)
+    {
+        data.resize(header.size);
+        ok = header.size == 0 ||
+             pread(fd, &data[0], header.size, sizeof(header)) == static_cast<ssize_t>(header.size);
+    }
+
+    close(fd);
+
+    if (!ok)
+        throw std::runtime_error("SavedState: malformed state");
+
+    // The pid doesn't change in exec(), any other pid means a stale state
+    if (header.pid != getpid())
+        throw std::runtime_error("SavedState: stale state");
+
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+        SavedStateRecord recordHeader;
+        if (data.size() - offset < sizeof(recordHeader))
+            throw std::runtime_error("SavedState: truncated record");
+
+        memcpy(&recordHeader, data.data() + offset, sizeof(recordHeader));
+        offset += sizeof(recordHeader);
+
+        const size_t valuesSize = recordHeader.count * sizeof(int32_t);
+        if (data.size() - offset < valuesSize + padded(recordHeader.length))
+            throw std::runtime_error("SavedState: truncated record");
+
+        Record record;
+        record.tag = recordHeader.tag;
+        record.values.resize(recordHeader.count);
+        if (recordHeader.count)
+            memcpy(&record.values[0], data.data() + offset, valuesSize);
+        offset += valuesSize;
+
+        record.str.assign(data, offset, recordHeader.length);
+        offset += padded(recordHeader.length);
+
+        m_records.push_back(record);
+    }
+}
+
+const SavedState::RecordVect & SavedState::records() const
+{
+    return m_records;
+}
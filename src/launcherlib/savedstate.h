@@ -0,0 +1,131 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef SAVEDSTATE_H
+#define SAVEDSTATE_H
+
+#include "launcherlib.h"
+
+#include <stdint.h>
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+/*!
+ * \class SavedState
+ * \brief Daemon state handed over to the re-executed daemon.
+ *
+ * The state is a list of tagged records serialized into a memfd whose
+ * descriptor survives exec(). Each record carries a tag, a number of
+ * integers and an optional string. Records with unknown tags are skipped,
+ * so new kinds of state can be added without breaking the format.
+ *
+ * Layout: a header {magic, version, pid, size} followed by size bytes of
+ * records. A record is {uint16 tag, uint16 value count, uint32 string
+ * length}, the int32 values and the string padded to four bytes.
+ */
+class DECL_EXPORT SavedState
+{
+public:
+
+    //! Magic number of the serialized state
+    static const uint32_t MAGIC = 0x5a7e0000;
+
+    //! Version of the format, increased on incompatible changes
+    static const uint32_t VERSION = 1;
+
+    /*! Kinds of records. The records of a booster (TAG_BOOSTER_PID,
+     *  TAG_LAUNCHER_SOCKET, TAG_CONNECTION_SOCKET and TAG_WARM_BOOSTER)
+     *  carry the booster type as their string. TAG_QUEUED_CONNECTION
+     *  carries the booster type, a zero byte and the header read from the
+     *  invoker.
+     */
+    enum Tag
+    {
+        TAG_DEBUG_MODE = 1,
+        TAG_CHILD,
+        TAG_BOOSTER_INVOKER_PID,
+        TAG_BOOSTER_INVOKER_FD,
+        TAG_BOOSTER_PID,
+        TAG_SINGLE_INSTANCE,
+        TAG_LAUNCHER_SOCKET,
+        TAG_CONNECTION_SOCKET,
+        TAG_SIGPIPE_FD,
+        TAG_BOOT_MODE,
+        TAG_SOCKET_HASH,
+        TAG_CONNECTION_COUNT,
+        TAG_WARM_BOOSTER,
+        TAG_ON_DEMAND,
+        TAG_IDLE_TIMEOUT,
+        TAG_MEMORY_PRESSURE,
+        TAG_CHILD_TYPE,
+        TAG_QUEUED_CONNECTION
+    };
+
+    //! One piece of state
+    struct Record
+    {
+        uint32_t tag;
+        vector<int32_t> values;
+        string str;
+    };
+
+    typedef vector<Record> RecordVect;
+
+    //! Add a record with one value
+    void add(Tag tag, int32_t value);
+
+    //! Add a record with two values
+    void add(Tag tag, int32_t value1, int32_t value2);
+
+    //! Add a record with a value and a string
+    void add(Tag tag, int32_t value, const string & str);
+
+    //! Add a record with two values and a string
+    void add(Tag tag, int32_t value1, int32_t value2, const string & str);
+
+    //! Add a record with three values and a string
+    void add(Tag tag, int32_t value1, int32_t value2, int32_t value3, const string & str);
+
+    /*! \brief Serialize the records into a memfd.
+     *  The descriptor is left open over exec(), the caller takes the ownership.
+     *  \return the descriptor, throws std::runtime_error on failure.
+     */
+    int write() const;
+
+    /*! \brief Read records serialized by a daemon with the same pid
+     *  from fd and close fd. Throws std::runtime_error on failure.
+     */
+    void read(int fd);
+
+    //! Return the records in the order they were added
+    const RecordVect & records() const;
+
+private:
+
+    //! Records of the state
+    RecordVect m_records;
+};
+
+#endif // SAVEDSTATE_H
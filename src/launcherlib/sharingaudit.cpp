@@ -0,0 +1,320 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#include "sharingaudit.h"
+#include "logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+using std::pair;
+
+// Mappings printed per booster type, the rest are summed up
+static const unsigned int MAX_MAPPINGS = 20;
+
+SharingAudit::Usage::Usage() :
+    rss(0),
+    pss(0),
+    pssDirty(0),
+    sharedClean(0),
+    sharedDirty(0),
+    privateClean(0),
+    privateDirty(0)
+{}
+
+void SharingAudit::Usage::add(const Usage & other)
+{
+    rss += other.rss;
+    pss += other.pss;
+    pssDirty = pssDirty < 0 || other.pssDirty < 0 ? -1 : pssDirty + other.pssDirty;
+    sharedClean += other.sharedClean;
+    sharedDirty += other.sharedDirty;
+    privateClean += other.privateClean;
+    privateDirty += other.privateDirty;
+}
+
+long SharingAudit::Usage::saved() const
+{
+    long share;
+    if (pssDirty >= 0)
+    {
+        share = pssDirty - privateDirty;
+    }
+    else
+    {
+        // Kernels older than 6.0 have no Pss_Dirty. Split the
+        // proportional share of shared memory by clean and dirty.
+        const long shared = sharedClean + sharedDirty;
+        const long sharedPss = pss - privateClean - privateDirty;
+        share = shared > 0 ? sharedPss * sharedDirty / shared : 0;
+    }
+
+    return sharedDirty > share ? sharedDirty - share : 0;
+}
+
+void SharingAudit::addProcess(pid_t pid, Role role, const string & type)
+{
+    Process process;
+    process.pid = pid;
+    process.role = role;
+    process.type = type;
+    process.valid = false;
+    m_processes.push_back(process);
+}
+
+void SharingAudit::parseField(const char * line, Usage & usage)
+{
+    static const struct
+    {
+        const char * key;
+        long Usage::* field;
+    } fields[] =
+    {
+        { "Rss:", &Usage::rss },
+        { "Pss:", &Usage::pss },
+        { "Pss_Dirty:", &Usage::pssDirty },
+        { "Shared_Clean:", &Usage::sharedClean },
+        { "Shared_Dirty:", &Usage::sharedDirty },
+        { "Private_Clean:", &Usage::privateClean },
+        { "Private_Dirty:", &Usage::privateDirty }
+    };
+
+    for (unsigned int i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    {
+        const size_t length = strlen(fields[i].key);
+        if (strncmp(line, fields[i].key, length) == 0)
+        {
+            usage.*fields[i].field += atol(line + length);
+            return;
+        }
+    }
+}
+
+bool SharingAudit::readRollup(pid_t pid, Usage & total)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+
+    FILE * smaps = fopen(path, "re");
+    if (!smaps)
+        return false;
+
+    Usage usage;
+    usage.pssDirty = -1;
+
+    char line[256];
+    while (fgets(line, sizeof(line), smaps))
+    {
+        // Pss_Dirty starts from -1 to tell if the kernel reports it
+        if (strncmp(line, "Pss_Dirty:", 10) == 0)
+            usage.pssDirty = 0;
+
+        parseField(line, usage);
+    }
+
+    fclose(smaps);
+
+    total = usage;
+    return usage.rss > 0;
+}
+
+bool SharingAudit::readMappings(pid_t pid, MappingMap & mappings, Usage & total)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps", pid);
+
+    FILE * smaps = fopen(path, "re");
+    if (!smaps)
+        return false;
+
+    Usage sum;
+    Usage usage;
+    string name;
+    bool hasPssDirty = false;
+    bool first = true;
+
+    char line[4096];
+    while (fgets(line, sizeof(line), smaps))
+    {
+        // Header of a mapping: address range, permissions, offset,
+        // device, inode and the path, if any
+        unsigned long start, end;
+        int pathStart = 0;
+        if (sscanf(line, "%lx-%lx %*s %*s %*s %*s %n", &start, &end, &pathStart) == 2 && pathStart > 0)
+        {
+            if (!first)
+            {
+                mappings[name].add(usage);
+                sum.add(usage);
+            }
+
+            first = false;
+            usage = Usage();
+
+            name = line + pathStart;
+            name.erase(name.find_last_not_of(" \n") + 1);
+            if (name.empty())
+                name = "[anon]";
+        }
+        else
+        {
+            if (strncmp(line, "Pss_Dirty:", 10) == 0)
+                hasPssDirty = true;
+
+            parseField(line, usage);
+        }
+    }
+
+    fclose(smaps);
+
+    if (first)
+        return false;
+
+    mappings[name].add(usage);
+    sum.add(usage);
+
+    if (!hasPssDirty)
+    {
+        sum.pssDirty = -1;
+        for (MappingMap::iterator i = mappings.begin(); i != mappings.end(); i++)
+            i->second.pssDirty = -1;
+    }
+
+    total = sum;
+    return true;
+}
+
+static const char * roleName(SharingAudit::Role role)
+{
+    static const char * const names[] = { "daemon", "booster", "application" };
+    return names[role];
+}
+
+static void printUsage(FILE * report, const char * label, long rss, long pss,
+                       long sharedClean, long sharedDirty, long priv, long saved)
+{
+    fprintf(report, "%-28s %8ld %8ld %9ld %9ld %8ld %8ld\n",
+            label, rss, pss, sharedClean, sharedDirty, priv, saved);
+}
+
+bool SharingAudit::write(const string & path)
+{
+    typedef map<string, MappingMap> TypeMappingMap;
+    TypeMappingMap typeMappings;
+
+    // Only the mappings of applications are needed per mapping, the
+    // daemon and boosters are summed up by the kernel in smaps_rollup
+    for (vector<Process>::iterator i = m_processes.begin(); i != m_processes.end(); i++)
+    {
+        if (i->role == ROLE_APPLICATION)
+            i->valid = readMappings(i->pid, typeMappings[i->type], i->total);
+        else if (!(i->valid = readRollup(i->pid, i->total)))
+        {
+            // Kernels older than 4.14 have no smaps_rollup
+            MappingMap unused;
+            i->valid = readMappings(i->pid, unused, i->total);
+        }
+    }
+
+    FILE * report = fopen(path.c_str(), "we");
+    if (!report)
+    {
+        LOGGER_ERROR("SharingAudit: can't write %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    fprintf(report, "# Memory sharing of applauncherd %d, sizes in kB.\n", getpid());
+    fprintf(report, "# saved: shared-dirty memory paid for by other processes.\n\n");
+    fprintf(report, "%-28s %8s %8s %9s %9s %8s %8s\n",
+            "process", "rss", "pss", "sh-clean", "sh-dirty", "private", "saved");
+
+    typedef map<string, pair<int, long> > TypeSavingMap;
+    TypeSavingMap typeSavings;
+
+    for (vector<Process>::const_iterator i = m_processes.begin(); i != m_processes.end(); i++)
+    {
+        if (!i->valid)
+            continue;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s %d %s", roleName(i->role), i->pid,
+                 i->type.empty() ? "-" : i->type.c_str());
+
+        const Usage & u = i->total;
+        printUsage(report, label, u.rss, u.pss, u.sharedClean, u.sharedDirty,
+                   u.privateClean + u.privateDirty, u.saved());
+
+        if (i->role == ROLE_APPLICATION)
+        {
+            pair<int, long> & saving = typeSavings[i->type];
+            saving.first++;
+            saving.second += u.saved();
+        }
+    }
+
+    for (TypeMappingMap::const_iterator t = typeMappings.begin(); t != typeMappings.end(); t++)
+    {
+        const pair<int, long> & saving = typeSavings[t->first];
+        if (!saving.first)
+            continue;
+
+        fprintf(report, "\ntype %s: %d applications, %ld kB saved, %ld kB per application\n",
+                t->first.empty() ? "-" : t->first.c_str(), saving.first,
+                saving.second, saving.second / saving.first);
+
+        // Mappings with the largest savings first
+        vector<pair<long, string> > order;
+        for (MappingMap::const_iterator m = t->second.begin(); m != t->second.end(); m++)
+            order.push_back(std::make_pair(-m->second.saved(), m->first));
+        std::sort(order.begin(), order.end());
+
+        fprintf(report, "  %9s %9s %8s %8s  %s\n", "sh-clean", "sh-dirty", "private", "saved", "mapping");
+
+        Usage rest;
+        for (unsigned int i = 0; i < order.size(); i++)
+        {
+            const Usage & u = t->second.find(order[i].second)->second;
+            if (i >= MAX_MAPPINGS)
+            {
+                rest.add(u);
+                continue;
+            }
+
+            fprintf(report, "  %9ld %9ld %8ld %8ld  %s\n",
+                    u.sharedClean, u.sharedDirty, u.privateClean + u.privateDirty,
+                    u.saved(), order[i].second.c_str());
+        }
+
+        if (order.size() > MAX_MAPPINGS)
+        {
+            fprintf(report, "  %9ld %9ld %8ld %8ld  (%u other mappings)\n",
+                    rest.sharedClean, rest.sharedDirty, rest.privateClean + rest.privateDirty,
+                    rest.saved(), (unsigned int)(order.size() - MAX_MAPPINGS));
+        }
+    }
+
+    fclose(report);
+    return true;
+}
@@ -0,0 +1,128 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+#ifndef SHARINGAUDIT_H
+#define SHARINGAUDIT_H
+
+#include <sys/types.h>
+
+#include <string>
+
+using std::string;
+
+#include <vector>
+
+using std::vector;
+
+#include <map>
+
+using std::map;
+
+/*!
+ * \class SharingAudit
+ * \brief Measures the memory boosted applications share with their boosters.
+ *
+ * Reads \c /proc/<pid>/smaps_rollup and \c /proc/<pid>/smaps of the daemon,
+ * the boosters and the launched applications and attributes shared-clean,
+ * shared-dirty and private memory per process, per mapping and per booster
+ * type.
+ *
+ * Clean file pages would be shared through the page cache by a standalone
+ * exec as well, so only shared-dirty pages count as saved: pages written
+ * by the daemon or a booster before fork() and still shared copy-on-write.
+ * The saving of a process is its shared-dirty memory less its proportional
+ * share of that memory, i.e. the dirty pages other processes pay for.
+ */
+class SharingAudit
+{
+public:
+
+    //! Kinds of audited processes
+    enum Role
+    {
+        ROLE_DAEMON,
+        ROLE_BOOSTER,
+        ROLE_APPLICATION
+    };
+
+    /*! \brief Add a process to the audit.
+     *  \param pid Process to audit.
+     *  \param role What the process is.
+     *  \param type Booster type of the process, empty if not known.
+     */
+    void addProcess(pid_t pid, Role role, const string & type);
+
+    /*! \brief Read the memory maps of the processes and write the report.
+     *  Processes that exit before they are read are left out.
+     *  \param path File to write the report to.
+     *  \return false if the report can't be written.
+     */
+    bool write(const string & path);
+
+private:
+
+    //! Memory of a mapping or a sum of mappings, in kB
+    struct Usage
+    {
+        Usage();
+
+        //! Add the values of other
+        void add(const Usage & other);
+
+        //! Return the shared-dirty memory paid for by other processes
+        long saved() const;
+
+        long rss;
+        long pss;
+
+        //! Proportional dirty memory, -1 if the kernel doesn't report it
+        long pssDirty;
+
+        long sharedClean;
+        long sharedDirty;
+        long privateClean;
+        long privateDirty;
+    };
+
+    typedef map<string, Usage> MappingMap;
+
+    //! Process to audit
+    struct Process
+    {
+        pid_t pid;
+        Role role;
+        string type;
+        Usage total;
+        bool valid;
+    };
+
+    //! Parse a "Key: value kB" line of smaps into usage
+    static void parseField(const char * line, Usage & usage);
+
+    //! Read the totals of pid from smaps_rollup
+    static bool readRollup(pid_t pid, Usage & total);
+
+    //! Read the mappings of pid from smaps, summed by mapped path, and their total
+    static bool readMappings(pid_t pid, MappingMap & mappings, Usage & total);
+
+    //! Processes to audit
+    vector<Process> m_processes;
+};
+
+#endif // SHARINGAUDIT_H
@@ -18,7 +18,16 @@
 ****************************************************************************/
 
 #include "singleinstance.h"
+#include "logger.h"
+
 #include <dlfcn.h>
+#include <unistd.h>
+
+SingleInstance::SingleInstance() :
+    m_activationsPending(false),
+    m_activationFd(-1)
+{
+}
 
 bool SingleInstance::validateAndRegisterPlugin(void * handle)
 {
@@ -61,6 +70,19 @@ bool SingleInstance::validateAndRegisterPlugin(void * handle)
     m_pluginEntry->unlockFunc = unlock;
     m_pluginEntry->activateExistingInstanceFunc = activateExistingInstance;
 
+    // Use the asynchronous activation backend if the plugin has one
+    SingleInstanceActivationBackend & backend = m_pluginEntry->activationBackend;
+    backend.activateFunc = (activate_func_t)dlsym(handle, "activateExistingInstanceAsync");
+    backend.fdFunc       = (activation_fd_func_t)dlsym(handle, "activationFd");
+    backend.flushFunc    = (flush_activations_func_t)dlsym(handle, "flushActivations");
+
+    if (!backend.activateFunc || !backend.fdFunc || !backend.flushFunc)
+    {
+        backend.activateFunc = activateExistingInstance;
+        backend.fdFunc       = NULL;
+        backend.flushFunc    = NULL;
+    }
+
     return true;
 }
 
@@ -76,4 +98,75 @@ void SingleInstance::closePlugin()
         dlclose(m_pluginEntry->handle);
         m_pluginEntry.reset();
     }
+
+    m_activationsPending = false;
+    m_activationFd = -1;
+}
+
+bool SingleInstance::activateExistingInstance(const string & binaryName)
+{
+    if (!m_pluginEntry)
+        return false;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // Users often tap twice, the second activation would do nothing new
+    ActivationMap::iterator it = m_lastActivations.find(binaryName);
+    if (it != m_lastActivations.end())
+    {
+        const long elapsedMs = (now.tv_sec - it->second.tv_sec) * 1000 +
+                               (now.tv_nsec - it->second.tv_nsec) / 1000000;
+        if (elapsedMs >= 0 && elapsedMs < ACTIVATION_COALESCE_MS)
+        {
+            LOGGER_DEBUG("SingleInstance: coalescing activation of '%s'", binaryName.c_str());
+            return true;
+        }
+    }
+
+    // Forget old activations so that the map doesn't grow forever
+    ActivationMap::iterator i = m_lastActivations.begin();
+    while (i != m_lastActivations.end())
+    {
+        if (now.tv_sec - i->second.tv_sec > 1)
+            m_lastActivations.erase(i++);
+        else
+            ++i;
+    }
+
+    const SingleInstanceActivationBackend & backend = m_pluginEntry->activationBackend;
+    if (!backend.activateFunc(binaryName.c_str()))
+        return false;
+
+    m_lastActivations[binaryName] = now;
+
+    if (backend.flushFunc)
+    {
+        m_activationFd = backend.fdFunc();
+        m_activationsPending = backend.flushFunc();
+    }
+
+    return true;
+}
+
+int SingleInstance::pendingActivationFd() const
+{
+    return m_activationsPending ? m_activationFd : -1;
+}
+
+void SingleInstance::flushActivations()
+{
+    if (m_activationsPending && m_pluginEntry)
+        m_activationsPending = m_pluginEntry->activationBackend.flushFunc();
+}
+
+void SingleInstance::closeActivationFd()
+{
+    if (m_activationFd != -1)
+    {
+        close(m_activationFd);
+        m_activationFd = -1;
+    }
+
+    m_activationsPending = false;
 }
@@ -25,6 +25,16 @@
 
 using std::tr1::shared_ptr;
 
+#include <string>
+
+using std::string;
+
+#include <map>
+
+using std::map;
+
+#include <time.h>
+
 // Function pointer type for lock()
 typedef bool (*lock_func_t)(const char *);
 
@@ -34,6 +44,32 @@ typedef void (*unlock_func_t)();
 // Function pointer type for activateExistingInstance(const char * binaryName)
 typedef bool (*activate_func_t)(const char *);
 
+// Function pointer type for activationFd()
+typedef int (*activation_fd_func_t)();
+
+// Function pointer type for flushActivations()
+typedef bool (*flush_activations_func_t)();
+
+/*!
+ * \brief Backend that activates the window of a running application.
+ *
+ * The plugin provides an asynchronous backend by exporting
+ * activateExistingInstanceAsync(), activationFd() and flushActivations().
+ * Otherwise the blocking activateExistingInstance() is used and
+ * fdFunc and flushFunc are NULL.
+ */
+struct SingleInstanceActivationBackend
+{
+    //! Queue activation of the given binary without blocking
+    activate_func_t activateFunc;
+
+    //! Return the fd to wait for writability while activations are pending, or -1
+    activation_fd_func_t fdFunc;
+
+    //! Send queued activations without blocking, return true if some are still pending
+    flush_activations_func_t flushFunc;
+};
+
 //! Single instance plugin entry
 struct SingleInstancePluginEntry
 {
@@ -46,6 +82,9 @@ struct SingleInstancePluginEntry
     //! Activate existing instance
     activate_func_t activateExistingInstanceFunc;
 
+    //! Backend used by SingleInstance::activateExistingInstance()
+    SingleInstanceActivationBackend activationBackend;
+
     //! Handle to the plugin
     void * handle;
 };
@@ -55,6 +94,11 @@ class DECL_EXPORT SingleInstance
 {
 public:
 
+    //! Activations of the same binary closer than this are coalesced
+    static const int ACTIVATION_COALESCE_MS = 500;
+
+    SingleInstance();
+
     /*! Validate given plugin library handle and register.
      *  Returns true if succeeded.
      */
@@ -66,10 +110,39 @@ public:
     //! dlclose() the plugin
     void closePlugin();
 
+    /*! \brief Activate the window of a running application through the
+     *  activation backend. Doesn't block if the backend is asynchronous.
+     *  A repeated activation of the same binary within
+     *  ACTIVATION_COALESCE_MS is dropped.
+     *  \return false if the activation failed or no plugin is loaded.
+     */
+    bool activateExistingInstance(const string & binaryName);
+
+    //! Return the fd to wait for writability, or -1 if nothing is pending
+    int pendingActivationFd() const;
+
+    //! Continue sending pending activations without blocking
+    void flushActivations();
+
+    /*! \brief Close the fd of the activation backend in a forked child.
+     *  The plugin opens a new connection if the child activates.
+     */
+    void closeActivationFd();
+
 private:
 
     //! The plugin entry
     shared_ptr<SingleInstancePluginEntry> m_pluginEntry;
+
+    //! True if the backend has activations waiting to be sent
+    bool m_activationsPending;
+
+    //! Fd of the activation backend connection, -1 if not known
+    int m_activationFd;
+
+    //! Time of the latest activation of each binary
+    typedef map<string, struct timespec> ActivationMap;
+    ActivationMap m_lastActivations;
 };
 
 #endif // SINGLEINSTANCE_H
@@ -19,17 +19,21 @@
 
 #include "socketmanager.h"
 #include "logger.h"
+#include "protocol.h"
 
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <errno.h>
 #include <sstream>
+#include <systemd/sd-daemon.h>
 
 SocketManager::SocketManager()
 {
@@ -42,12 +46,37 @@ SocketManager::SocketManager()
 
     if (mkdir(m_socketRootPath.c_str(), S_IRUSR | S_IWUSR | S_IXUSR) != 0) {
         if (errno != EEXIST) {
-            Logger::logError("Daemon: Cannot create socket root directory %s: %s\n",
-                             m_socketRootPath.c_str(), strerror(errno));
+            LOGGER_ERROR("Daemon: Cannot create socket root directory %s: %s\n",
+                         m_socketRootPath.c_str(), strerror(errno));
         }
     }
 
     m_socketRootPath += '/';
+
+    // Sockets passed in by the service manager. The environment is unset
+    // so that boosters and applications don't think they got them too.
+    const int count = sd_listen_fds(1);
+    for (int i = 0; i < count; i++)
+        m_activatedSockets.push_back(SD_LISTEN_FDS_START + i);
+}
+
+int SocketManager::takeActivatedSocket(const string & socketPath)
+{
+    for (vector<int>::iterator i = m_activatedSockets.begin(); i != m_activatedSockets.end(); i++)
+    {
+        const int fd = *i;
+        if (sd_is_socket_unix(fd, SOCK_STREAM, 1, socketPath.c_str(), 0) > 0)
+        {
+            m_activatedSockets.erase(i);
+
+            // Passed in sockets are close-on-exec, but the socket has to
+            // survive re-exec like the ones created by the daemon
+            fcntl(fd, F_SETFD, 0);
+            return fd;
+        }
+    }
+
+    return -1;
 }
 
 void SocketManager::initSocket(const string & socketId)
@@ -58,7 +87,18 @@ void SocketManager::initSocket(const string & socketId)
     // exist for that id / path.
     if (m_socketHash.find(socketId) == m_socketHash.end())
     {
-        Logger::logDebug("SocketManager: Initing socket at '%s'..", socketPath.c_str());
+        const int activatedFd = takeActivatedSocket(socketPath);
+        if (activatedFd != -1)
+        {
+            LOGGER_DEBUG("SocketManager: Using passed in socket %d at '%s'",
+                         activatedFd, socketPath.c_str());
+
+            writeCapabilities(socketPath);
+            m_socketHash[socketId] = activatedFd;
+            return;
+        }
+
+        LOGGER_DEBUG("SocketManager: Initing socket at '%s'..", socketPath.c_str());
 
         // Create a new local socket
         int socketFd = socket(PF_UNIX, SOCK_STREAM, 0);
@@ -78,7 +118,7 @@ void SocketManager::initSocket(const string & socketId)
             {
                 std::string msg("SocketManager: Failed to unlink existing socket file '");
                 msg += socketPath + "': " + strerror(errno);
-                Logger::logWarning(msg.c_str());
+                LOGGER_WARNING("%s", msg.c_str());
             }
         }
 
@@ -99,8 +139,9 @@ void SocketManager::initSocket(const string & socketId)
             throw std::runtime_error(msg);
         }
 
-        // Listen to the socket
-        if (listen(socketFd, 10) < 0)
+        // Listen to the socket. The daemon accepts connections into its own
+        // queue as fast as it can, the backlog only has to absorb bursts.
+        if (listen(socketFd, SOMAXCONN) < 0)
         {
             std::string msg("SocketManager: Failed to listen to socket (fd=");
             std::stringstream ss;
@@ -112,9 +153,51 @@ void SocketManager::initSocket(const string & socketId)
         // Set permissions
         chmod(socketPath.c_str(), S_IRUSR | S_IWUSR | S_IXUSR);
 
+        // Tell invokers what they can ask for on this socket
+        writeCapabilities(socketPath);
+
         // Store path <-> file descriptor mapping
         m_socketHash[socketId] = socketFd;
     }
+    else
+    {
+        // A socket kept over re-exec was published by the previous
+        // daemon binary, which may have supported less
+        writeCapabilities(socketPath);
+    }
+}
+
+void SocketManager::writeCapabilities(const string & socketPath)
+{
+    struct invoker_caps caps;
+    caps.magic       = INVOKER_CAPS_MAGIC | INVOKER_MSG_MAGIC_VERSION;
+    caps.features    = INVOKER_CAPS_FEATURE_NO_ACK | INVOKER_CAPS_FEATURE_BATCH |
+                       INVOKER_CAPS_FEATURE_BACKGROUND | INVOKER_CAPS_FEATURE_CPU_BOOST;
+    caps.args_max    = INVOKER_ARGS_MAX;
+    caps.env_max     = INVOKER_ENV_MAX;
+    caps.str_len_max = INVOKER_STR_LEN_MAX;
+    caps.batch_max   = INVOKER_BATCH_MAX_ENTRIES;
+
+    // Write to a temporary file and rename it so that invokers
+    // never see a partially written file
+    const string capsPath = socketPath + INVOKER_CAPS_SUFFIX;
+    const string tmpPath  = capsPath + ".tmp";
+
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        LOGGER_WARNING("SocketManager: Failed to create '%s': %s", tmpPath.c_str(), strerror(errno));
+        return;
+    }
+
+    bool ok = write(fd, &caps, sizeof(caps)) == sizeof(caps);
+    close(fd);
+
+    if (!ok || rename(tmpPath.c_str(), capsPath.c_str()) == -1)
+    {
+        LOGGER_WARNING("SocketManager: Failed to write '%s': %s", capsPath.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+    }
 }
 
 void SocketManager::closeSocket(const string & socketId)
@@ -23,15 +23,21 @@
 #include "launcherlib.h"
 #include <map>
 #include <string>
+#include <vector>
 
 using std::map;
 using std::string;
+using std::vector;
 
 /*!
  * \class SocketManager
  *
  * SocketManager Manages sockets that are used in the invoker <-> booster
  * communication.
+ *
+ * Listening sockets passed in by the service manager (LISTEN_FDS, see
+ * sd_listen_fds(3)) are used instead of new ones for the socket paths
+ * they are bound to.
  */
 class DECL_EXPORT SocketManager
 {
@@ -39,6 +45,8 @@ public:
     SocketManager();
 
     /*! \brief Initialize a file socket.
+     *  Uses a passed in listening socket bound to the path if there is one.
+     *  The capabilities of an already initialized socket are published again.
      *  \param socketId Path to the socket file.
      */
     void initSocket(const string & socketId);
@@ -76,8 +84,17 @@ public:
 
 private:
 
+    //! Publish the protocol capabilities next to the socket at socketPath
+    void writeCapabilities(const string & socketPath);
+
+    //! Take the passed in listening socket bound to socketPath, -1 if there is none
+    int takeActivatedSocket(const string & socketPath);
+
     SocketHash m_socketHash;
 
+    //! Passed in listening sockets not taken into use yet
+    vector<int> m_activatedSockets;
+
     //! Root path for booster sockets
     string m_socketRootPath;
 
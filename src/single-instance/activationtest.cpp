@@ -0,0 +1,206 @@
+/***************************************************************************
+**
+** Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies).
+** All rights reserved.
+** Contact: Nokia Corporation (directui@nokia.com)
+**
+** This file is part of applauncherd
+**
+** If you have questions regarding the use of this file, please contact
+** Nokia at directui@nokia.com.
+**
+** This library is free software; you can redistribute it and/or
+** modify it under the terms of the GNU Lesser General Public
+** License version 2.1 as published by the Free Software Foundation
+** and appearing in the file LICENSE.LGPL included in the packaging
+** of this file.
+**
+****************************************************************************/
+
+/*
+ * Checks the asynchronous activation backend of the single-instance plugin
+ * against a fake org.nemomobile.lipstick on the session bus: the first
+ * activation sends one launchProcess call, a repeated one within
+ * SingleInstance::ACTIVATION_COALESCE_MS is coalesced and a later one is
+ * sent again. Run it with run-activationtest.sh, which starts a private
+ * session bus.
+ *
+ * Usage: single-instance-activationtest <single-instance plugin>
+ */
+
+#include "singleinstance.h"
+
+#include <dbus/dbus.h>
+#include <dlfcn.h>
+#include <sys/select.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+static const char * const APP_NAME = "/usr/bin/activationtest-app";
+
+// Milliseconds of CLOCK_MONOTONIC
+static long long monotonicMillis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+// Own the name of the home screen on the session bus
+static DBusConnection * exportFakeLipstick()
+{
+    DBusError error;
+    dbus_error_init(&error);
+
+    DBusConnection * bus = dbus_bus_get_private(DBUS_BUS_SESSION, &error);
+    if (!bus)
+    {
+        fprintf(stderr, "Can't connect to the session bus: %s\n", error.message);
+        dbus_error_free(&error);
+        return NULL;
+    }
+
+    dbus_connection_set_exit_on_disconnect(bus, FALSE);
+
+    if (dbus_bus_request_name(bus, "org.nemomobile.lipstick", DBUS_NAME_FLAG_DO_NOT_QUEUE,
+                              &error) != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER)
+    {
+        fprintf(stderr, "Can't own org.nemomobile.lipstick: %s\n",
+                dbus_error_is_set(&error) ? error.message : "name is taken");
+        dbus_error_free(&error);
+        dbus_connection_close(bus);
+        dbus_connection_unref(bus);
+        return NULL;
+    }
+
+    return bus;
+}
+
+// Let the backend send its pending activations the way the daemon does
+static bool flushActivations(SingleInstance & singleInstance)
+{
+    const long long deadline = monotonicMillis() + 1000;
+
+    int fd;
+    while ((fd = singleInstance.pendingActivationFd()) != -1)
+    {
+        if (monotonicMillis() > deadline)
+            return false;
+
+        fd_set wfds;
+        FD_ZERO(&wfds);
+        FD_SET(fd, &wfds);
+
+        struct timeval timeout = {0, 100000};
+        if (select(fd + 1, NULL, &wfds, NULL, &timeout) > 0)
+            singleInstance.flushActivations();
+    }
+
+    return true;
+}
+
+// Count the launchProcess calls of APP_NAME received within timeoutMs
+static int receiveActivations(DBusConnection * bus, int timeoutMs)
+{
+    int count = 0;
+    const long long deadline = monotonicMillis() + timeoutMs;
+
+    long long left;
+    while ((left = deadline - monotonicMillis()) > 0)
+    {
+        if (!dbus_connection_read_write(bus, static_cast<int>(left)))
+            break;
+
+        DBusMessage * msg;
+        while ((msg = dbus_connection_pop_message(bus)) != NULL)
+        {
+            const char * name = NULL;
+            if (dbus_message_is_method_call(msg, "local.Lipstick.WindowModel", "launchProcess") &&
+                dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID) &&
+                strcmp(name, APP_NAME) == 0)
+            {
+                count++;
+            }
+
+            dbus_message_unref(msg);
+        }
+    }
+
+    return count;
+}
+
+// Activate APP_NAME, return the number of calls that reached the fake home screen
+static int activate(SingleInstance & singleInstance, DBusConnection * bus, int times)
+{
+    for (int i = 0; i < times; i++)
+    {
+        if (!singleInstance.activateExistingInstance(APP_NAME))
+        {
+            fprintf(stderr, "Activation failed\n");
+            return -1;
+        }
+    }
+
+    if (!flushActivations(singleInstance))
+    {
+        fprintf(stderr, "Activations are still pending\n");
+        return -1;
+    }
+
+    return receiveActivations(bus, SingleInstance::ACTIVATION_COALESCE_MS / 2);
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <single-instance plugin>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    DBusConnection * bus = exportFakeLipstick();
+    if (!bus)
+        return EXIT_FAILURE;
+
+    void * handle = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        fprintf(stderr, "Can't load %s: %s\n", argv[1], dlerror());
+        return EXIT_FAILURE;
+    }
+
+    SingleInstance singleInstance;
+    if (!singleInstance.validateAndRegisterPlugin(handle) ||
+        !singleInstance.pluginEntry()->activationBackend.flushFunc)
+    {
+        fprintf(stderr, "%s has no asynchronous activation backend\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    int failures = 0;
+
+    // A double tap sends one call
+    const long long first = monotonicMillis();
+    int calls = activate(singleInstance, bus, 2);
+    printf("%s: two activations sent %d call(s)\n", calls == 1 ? "PASS" : "FAIL", calls);
+    if (calls != 1)
+        failures++;
+
+    // Once the interval is over the next activation goes through again
+    const long long next = first + SingleInstance::ACTIVATION_COALESCE_MS + 100;
+    while (monotonicMillis() < next)
+        receiveActivations(bus, static_cast<int>(next - monotonicMillis()));
+
+    calls = activate(singleInstance, bus, 1);
+    printf("%s: a later activation sent %d call(s)\n", calls == 1 ? "PASS" : "FAIL", calls);
+    if (calls != 1)
+        failures++;
+
+    singleInstance.closePlugin();
+    dbus_connection_close(bus);
+    dbus_connection_unref(bus);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -40,6 +40,12 @@ extern "C" {
 namespace
 {
     int g_lockFd = -1;
+
+    // Session bus connection kept open between activations
+    DBusConnection * g_bus = NULL;
+
+    // Process that opened g_bus, a forked child must not use it
+    pid_t g_busPid = 0;
     const std::string LOCK_PATH_BASE(std::string(getenv("XDG_RUNTIME_DIR"))+"/single-instance-locks/");
     const std::string LOCK_FILE_NAME("instance.lock");
 }
@@ -69,6 +75,43 @@ static bool mkpath(const std::string & path)
     return true;
 }
 
+//! Return the session bus connection, connecting if needed
+static DBusConnection * sessionBus()
+{
+    if (g_bus && (g_busPid != getpid() || !dbus_connection_get_is_connected(g_bus)))
+    {
+        // A connection inherited over fork() belongs to the parent,
+        // so it is only dropped, not closed
+        if (g_busPid == getpid())
+        {
+            dbus_connection_close(g_bus);
+            dbus_connection_unref(g_bus);
+        }
+        g_bus = NULL;
+    }
+
+    if (!g_bus)
+    {
+        DBusError error;
+        dbus_error_init(&error);
+
+        // A private connection so that closing it doesn't
+        // affect other users of the shared one
+        g_bus = dbus_bus_get_private(DBUS_BUS_SESSION, &error);
+        if (!g_bus)
+        {
+            report(report_error, "Can't get session bus connection: %s\n", error.message);
+            dbus_error_free(&error);
+            return NULL;
+        }
+
+        dbus_connection_set_exit_on_disconnect(g_bus, FALSE);
+        g_busPid = getpid();
+    }
+
+    return g_bus;
+}
+
 //! Print help.
 static void printHelp()
 {
@@ -140,16 +183,19 @@ extern "C"
         }
     }
 
-    //! Activate existing application 
-    DECL_EXPORT bool activateExistingInstance(const char * binaryName)
+    /*!
+     * \brief Queue activation of an existing application.
+     *
+     * The message is sent by flushActivations(), this never blocks.
+     *
+     * \param binaryName Full path to the binary.
+     * \return true if the message was queued.
+     */
+    DECL_EXPORT bool activateExistingInstanceAsync(const char * binaryName)
     {
-        DBusError error;
-
-        dbus_error_init(&error);
-        DBusConnection *bus = dbus_bus_get(DBUS_BUS_SESSION, &error);
+        DBusConnection *bus = sessionBus();
         if (!bus) {
-            report(report_error, "Can't get session bus connection");
-            goto err;
+            return false;
         }
 
         DBusMessage *msg;
@@ -161,27 +207,73 @@ extern "C"
                                            "launchProcess");
         if (!msg) {
             report(report_error, "Can't allocate bus message");
-            goto err;
+            return false;
         }
 
+        // Nobody reads replies from the persistent connection
+        dbus_message_set_no_reply(msg, TRUE);
+
         dbus_message_iter_init_append(msg, &args);
         if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &binaryName)) {
             report(report_error, "Can't allocate bus message");
-            goto err;
+            dbus_message_unref(msg);
+            return false;
         }
 
-        if (!dbus_connection_send(bus, msg, NULL)) {
+        bool sent = dbus_connection_send(bus, msg, NULL);
+        dbus_message_unref(msg);
+
+        if (!sent) {
             report(report_error, "Can't send message");
-            goto err;
+            return false;
         }
 
-        /* as we don't have a guarenteed mainloop, we must flush */
-        dbus_connection_flush(bus);
         return true;
+    }
+
+    //! Return the fd of the bus connection used for activations, or -1
+    DECL_EXPORT int activationFd()
+    {
+        int fd = -1;
+        if (!g_bus || g_busPid != getpid() || !dbus_connection_get_unix_fd(g_bus, &fd)) {
+            return -1;
+        }
+
+        return fd;
+    }
 
-err:
-        dbus_error_free(&error);
-        return false;
+    /*!
+     * \brief Send queued activations as far as possible without blocking.
+     * \return true if some are still waiting, the caller should call this
+     * again when activationFd() becomes writable.
+     */
+    DECL_EXPORT bool flushActivations()
+    {
+        if (!g_bus || g_busPid != getpid()) {
+            return false;
+        }
+
+        dbus_connection_read_write(g_bus, 0);
+
+        // Nothing is dispatched, so drop whatever the bus sent us
+        DBusMessage *msg;
+        while ((msg = dbus_connection_pop_message(g_bus)) != NULL) {
+            dbus_message_unref(msg);
+        }
+
+        return dbus_connection_has_messages_to_send(g_bus);
+    }
+
+    //! Activate existing application 
+    DECL_EXPORT bool activateExistingInstance(const char * binaryName)
+    {
+        if (!activateExistingInstanceAsync(binaryName)) {
+            return false;
+        }
+
+        /* as we don't have a guarenteed mainloop, we must flush */
+        dbus_connection_flush(g_bus);
+        return true;
     }
 }
 
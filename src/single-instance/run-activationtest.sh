@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Runs single-instance-activationtest on a private session bus, so that
+# the fake org.nemomobile.lipstick doesn't clash with a real one.
+#
+# Usage: run-activationtest.sh <test binary> <single-instance plugin>
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 <test binary> <single-instance plugin>" >&2
+    exit 1
+fi
+
+TMPDIR=$(mktemp -d) || exit 1
+
+if ! dbus-daemon --session --fork --print-address=3 --print-pid=4 \
+        3>"$TMPDIR/address" 4>"$TMPDIR/pid"; then
+    echo "$0: can't start dbus-daemon" >&2
+    rm -rf "$TMPDIR"
+    exit 1
+fi
+
+DBUS_SESSION_BUS_ADDRESS=$(cat "$TMPDIR/address")
+export DBUS_SESSION_BUS_ADDRESS
+
+# The plugin keeps its lock files there
+XDG_RUNTIME_DIR="$TMPDIR"
+export XDG_RUNTIME_DIR
+
+"$1" "$2"
+STATUS=$?
+
+kill "$(cat "$TMPDIR/pid")"
+rm -rf "$TMPDIR"
+exit $STATUS